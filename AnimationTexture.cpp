@@ -0,0 +1,64 @@
+#include "AnimationTexture.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+
+namespace Diligent
+{
+
+AnimationTexture::AnimationTexture(const CreateInfo& CI) :
+    m_NumSamples{CI.NumSamples},
+    m_Period{CI.Period}
+{
+    VERIFY_EXPR(CI.NumTracks > 0 && CI.NumSamples > 1 && CI.Period > 0);
+
+    IRenderDevice* pDevice = CI.pDevice;
+
+    CreateUniformBuffer(pDevice, sizeof(Constants), "Animation constants CB", &m_pConstants);
+
+    TextureDesc TexDesc;
+    TexDesc.Name      = "Animation texture";
+    TexDesc.Type      = RESOURCE_DIM_TEX_2D;
+    TexDesc.Width     = CI.NumSamples;
+    TexDesc.Height    = CI.NumTracks * 3;
+    TexDesc.Format    = TEX_FORMAT_RGBA32_FLOAT;
+    TexDesc.Usage     = USAGE_IMMUTABLE;
+    TexDesc.BindFlags = BIND_SHADER_RESOURCE;
+
+    std::vector<float4>   Texels(size_t{TexDesc.Width} * TexDesc.Height);
+    std::vector<float4x4> Transforms(CI.NumTracks);
+    for (Uint32 Sample = 0; Sample < CI.NumSamples; ++Sample)
+    {
+        CI.Evaluate(CI.Period * static_cast<float>(Sample) / static_cast<float>(CI.NumSamples), Transforms.data());
+
+        for (Uint32 Track = 0; Track < CI.NumTracks; ++Track)
+        {
+            const float4x4& M = Transforms[Track];
+            for (Uint32 Col = 0; Col < 3; ++Col)
+                Texels[size_t{Track * 3 + Col} * TexDesc.Width + Sample] = float4{M.m[0][Col], M.m[1][Col], M.m[2][Col], M.m[3][Col]};
+        }
+    }
+
+    TextureSubResData Level0{Texels.data(), Uint64{TexDesc.Width} * sizeof(float4)};
+    TextureData       InitData{&Level0, 1};
+    pDevice->CreateTexture(TexDesc, &InitData, &m_pTexture);
+    m_pSRV = m_pTexture->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+}
+
+void AnimationTexture::SetView(IDeviceContext* pContext, const float4x4& ViewProj, double Time)
+{
+    // The time is wrapped in double precision, so the animation does not stutter after running for hours
+    double LoopTime = std::fmod(Time, m_Period);
+    if (LoopTime < 0)
+        LoopTime += m_Period;
+
+    MapHelper<Constants> CBConstants(pContext, m_pConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+    CBConstants->ViewProj       = ViewProj;
+    CBConstants->SamplePosition = std::fmod(static_cast<float>(LoopTime / m_Period * m_NumSamples), static_cast<float>(m_NumSamples));
+    CBConstants->NumSamples     = m_NumSamples;
+}
+
+} // namespace Diligent
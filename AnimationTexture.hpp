@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Procedural transform animation baked into a float texture.
+//
+// Every track is an affine transform that loops over the same period. The transforms of
+// all tracks are sampled at regular intervals over one period when the texture is created.
+// Every sample of a track takes three texels in the texture: the columns of the transform,
+// each with the translation in w. Sample S of track T starts at texel (S, T * 3).
+//
+// The vertex shader reconstructs the transform of a track from the sample position of the
+// frame by blending the two nearest samples (see animation_texture.fxh). Animated objects
+// then need no CPU work and no per-object uploads, only the per-frame constants.
+class AnimationTexture
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice* pDevice   = nullptr;
+        Uint32         NumTracks = 0;
+
+        // Number of samples over one period, limited by the maximum texture width
+        Uint32 NumSamples = 1024;
+
+        // Length of the animation loop in seconds. Every track must repeat after it.
+        float Period = 0;
+
+        // Writes the transforms of all tracks at the given time to pTransforms
+        std::function<void(float Time, float4x4* pTransforms)> Evaluate;
+    };
+
+    // Must match AnimationConstants in animation_texture.fxh
+    struct Constants
+    {
+        float4x4 ViewProj;
+        // Position of the current time between the samples, in [0, NumSamples)
+        float    SamplePosition = 0;
+        Uint32   NumSamples     = 0;
+        Uint32   Padding[2]     = {};
+    };
+
+    explicit AnimationTexture(const CreateInfo& CI);
+
+    // Updates the constants for the current frame
+    void SetView(IDeviceContext* pContext, const float4x4& ViewProj, double Time);
+
+    IBuffer*      GetConstantsBuffer() const { return m_pConstants; }
+    ITextureView* GetSRV() const { return m_pSRV; }
+
+private:
+    const Uint32 m_NumSamples;
+    const double m_Period;
+
+    RefCntAutoPtr<IBuffer>      m_pConstants;
+    RefCntAutoPtr<ITexture>     m_pTexture;
+    RefCntAutoPtr<ITextureView> m_pSRV;
+};
+
+} // namespace Diligent
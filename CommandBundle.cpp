@@ -0,0 +1,112 @@
+#include "CommandBundle.hpp"
+
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+void CommandBundle::Reset()
+{
+    m_Commands.clear();
+    m_PipelineStates.clear();
+    m_SRBs.clear();
+    m_VertexBuffers.clear();
+    m_IndexBuffers.clear();
+    m_Draws.clear();
+    m_ReferencedObjects.clear();
+}
+
+void CommandBundle::AddCommand(COMMAND_TYPE Type, size_t ArgIndex)
+{
+    m_Commands.push_back({Type, static_cast<Uint32>(ArgIndex)});
+}
+
+void CommandBundle::SetPipelineState(IPipelineState* pPSO)
+{
+    VERIFY_EXPR(pPSO != nullptr);
+    AddCommand(COMMAND_TYPE_SET_PIPELINE_STATE, m_PipelineStates.size());
+    m_PipelineStates.push_back(pPSO);
+    m_ReferencedObjects.emplace_back(pPSO);
+}
+
+void CommandBundle::CommitShaderResources(IShaderResourceBinding* pSRB)
+{
+    VERIFY_EXPR(pSRB != nullptr);
+    AddCommand(COMMAND_TYPE_COMMIT_SHADER_RESOURCES, m_SRBs.size());
+    m_SRBs.push_back(pSRB);
+    m_ReferencedObjects.emplace_back(pSRB);
+}
+
+void CommandBundle::SetVertexBuffers(Uint32 StartSlot, Uint32 NumBuffers, IBuffer* const* ppBuffers, const Uint64* pOffsets)
+{
+    VERIFY(NumBuffers <= MaxVertexBuffers, "Too many vertex buffers");
+
+    VertexBuffersArgs Args;
+    Args.StartSlot  = StartSlot;
+    Args.NumBuffers = NumBuffers;
+    for (Uint32 i = 0; i < NumBuffers; ++i)
+    {
+        Args.ppBuffers[i] = ppBuffers[i];
+        Args.Offsets[i]   = pOffsets != nullptr ? pOffsets[i] : 0;
+        m_ReferencedObjects.emplace_back(ppBuffers[i]);
+    }
+
+    AddCommand(COMMAND_TYPE_SET_VERTEX_BUFFERS, m_VertexBuffers.size());
+    m_VertexBuffers.push_back(Args);
+}
+
+void CommandBundle::SetIndexBuffer(IBuffer* pIndexBuffer, Uint64 ByteOffset)
+{
+    AddCommand(COMMAND_TYPE_SET_INDEX_BUFFER, m_IndexBuffers.size());
+    m_IndexBuffers.push_back({pIndexBuffer, ByteOffset});
+    m_ReferencedObjects.emplace_back(pIndexBuffer);
+}
+
+void CommandBundle::DrawIndexed(const DrawIndexedAttribs& Attribs)
+{
+    AddCommand(COMMAND_TYPE_DRAW_INDEXED, m_Draws.size());
+    m_Draws.push_back(Attribs);
+}
+
+void CommandBundle::Execute(IDeviceContext* pContext)
+{
+    // Resources that are already in the required states are not transitioned again
+    const RESOURCE_STATE_TRANSITION_MODE TransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+
+    for (const Command& Cmd : m_Commands)
+    {
+        switch (Cmd.Type)
+        {
+            case COMMAND_TYPE_SET_PIPELINE_STATE:
+                pContext->SetPipelineState(m_PipelineStates[Cmd.ArgIndex]);
+                break;
+
+            case COMMAND_TYPE_COMMIT_SHADER_RESOURCES:
+                pContext->CommitShaderResources(m_SRBs[Cmd.ArgIndex], TransitionMode);
+                break;
+
+            case COMMAND_TYPE_SET_VERTEX_BUFFERS:
+            {
+                const VertexBuffersArgs& Args = m_VertexBuffers[Cmd.ArgIndex];
+                pContext->SetVertexBuffers(Args.StartSlot, Args.NumBuffers, Args.ppBuffers, Args.Offsets, TransitionMode, SET_VERTEX_BUFFERS_FLAG_RESET);
+                break;
+            }
+
+            case COMMAND_TYPE_SET_INDEX_BUFFER:
+            {
+                const IndexBufferArgs& Args = m_IndexBuffers[Cmd.ArgIndex];
+                pContext->SetIndexBuffer(Args.pBuffer, Args.ByteOffset, TransitionMode);
+                break;
+            }
+
+            case COMMAND_TYPE_DRAW_INDEXED:
+                pContext->DrawIndexed(m_Draws[Cmd.ArgIndex]);
+                break;
+
+            default:
+                UNEXPECTED("Unexpected command type");
+        }
+    }
+}
+
+} // namespace Diligent
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+#include "DeviceContext.h"
+#include "PipelineState.h"
+#include "RefCntAutoPtr.hpp"
+
+namespace Diligent
+{
+
+// A sequence of state and draw commands that is recorded once and replayed every frame.
+//
+// This is a CPU-side replay, not a GPU bundle: Execute() issues every recorded command through
+// the regular device context calls, so the per-draw submission cost stays the same. Command
+// lists produced by deferred contexts can only be executed once, so there is no reusable
+// backend object to record into. What replaying saves is the per-frame work of building the
+// frame: sorting, per-draw constant updates and per-draw resource commits. Every replay
+// transitions the resources it uses, since other render paths may have moved them to other
+// states since the last one (e.g. the geometry pool is a shader resource for vertex pulling).
+class CommandBundle
+{
+public:
+    void Reset();
+
+    void SetPipelineState(IPipelineState* pPSO);
+    void CommitShaderResources(IShaderResourceBinding* pSRB);
+    void SetVertexBuffers(Uint32 StartSlot, Uint32 NumBuffers, IBuffer* const* ppBuffers, const Uint64* pOffsets);
+    void SetIndexBuffer(IBuffer* pIndexBuffer, Uint64 ByteOffset);
+    void DrawIndexed(const DrawIndexedAttribs& Attribs);
+
+    void Execute(IDeviceContext* pContext);
+
+    bool   IsEmpty() const { return m_Commands.empty(); }
+    size_t GetNumCommands() const { return m_Commands.size(); }
+
+private:
+    enum COMMAND_TYPE : Uint8
+    {
+        COMMAND_TYPE_SET_PIPELINE_STATE,
+        COMMAND_TYPE_COMMIT_SHADER_RESOURCES,
+        COMMAND_TYPE_SET_VERTEX_BUFFERS,
+        COMMAND_TYPE_SET_INDEX_BUFFER,
+        COMMAND_TYPE_DRAW_INDEXED
+    };
+
+    static constexpr Uint32 MaxVertexBuffers = 4;
+
+    struct Command
+    {
+        COMMAND_TYPE Type;
+
+        // Index of the first argument in the argument array that corresponds to the command type
+        Uint32 ArgIndex;
+    };
+
+    struct VertexBuffersArgs
+    {
+        Uint32   StartSlot                   = 0;
+        Uint32   NumBuffers                  = 0;
+        IBuffer* ppBuffers[MaxVertexBuffers] = {};
+        Uint64   Offsets[MaxVertexBuffers]   = {};
+    };
+
+    struct IndexBufferArgs
+    {
+        IBuffer* pBuffer    = nullptr;
+        Uint64   ByteOffset = 0;
+    };
+
+    void AddCommand(COMMAND_TYPE Type, size_t ArgIndex);
+
+    std::vector<Command>                 m_Commands;
+    std::vector<IPipelineState*>         m_PipelineStates;
+    std::vector<IShaderResourceBinding*> m_SRBs;
+    std::vector<VertexBuffersArgs>       m_VertexBuffers;
+    std::vector<IndexBufferArgs>         m_IndexBuffers;
+    std::vector<DrawIndexedAttribs>      m_Draws;
+    std::vector<RefCntAutoPtr<IObject>>  m_ReferencedObjects;
+};
+
+} // namespace Diligent
@@ -0,0 +1,198 @@
+#include "DebugDraw.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+#include "ShaderFeatures.hpp"
+
+namespace Diligent
+{
+
+DebugDraw::DebugDraw(const CreateInfo& CI) :
+    m_MaxVertices{CI.MaxVertices & ~1u}
+{
+    IRenderDevice* pDevice = CI.pDevice;
+
+    CreateUniformBuffer(pDevice, sizeof(float4x4), "Debug draw constants CB", &m_pConstants);
+
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name           = "Debug draw vertex buffer";
+    VertBuffDesc.Usage          = USAGE_DYNAMIC;
+    VertBuffDesc.BindFlags      = BIND_VERTEX_BUFFER;
+    VertBuffDesc.CPUAccessFlags = CPU_ACCESS_WRITE;
+    VertBuffDesc.Size           = Uint64{m_MaxVertices} * sizeof(Vertex);
+    pDevice->CreateBuffer(VertBuffDesc, nullptr, &m_pVertexBuffer);
+
+    GraphicsPipelineStateCreateInfo PSOCreateInfo;
+
+    PSOCreateInfo.PSODesc.Name         = "Debug draw PSO";
+    PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_GRAPHICS;
+    PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+    // clang-format off
+    PSOCreateInfo.GraphicsPipeline.NumRenderTargets             = 1;
+    PSOCreateInfo.GraphicsPipeline.RTVFormats[0]                = CI.RTVFormat;
+    PSOCreateInfo.GraphicsPipeline.DSVFormat                    = CI.DSVFormat;
+    PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_LINE_LIST;
+    PSOCreateInfo.GraphicsPipeline.RasterizerDesc.CullMode      = CULL_MODE_NONE;
+    // Overlays are depth-tested against the scene, but do not occlude each other
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable      = True;
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthWriteEnable = False;
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthFunc        = COMPARISON_FUNC_LESS_EQUAL;
+    // clang-format on
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage             = SHADER_SOURCE_LANGUAGE_HLSL;
+    ShaderCI.CompileFlags               = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+    ShaderCI.pShaderSourceStreamFactory = CI.pShaderSourceFactory;
+
+    ShaderFeatures Features{CI.UseSpecializationConstants};
+    Features.AddBool("ConvertPSOutputToGamma", SHADER_TYPE_PIXEL, CI.ConvertPSOutputToGamma);
+
+    ShaderMacroHelper Macros;
+    Features.AddShaderMacros(Macros);
+    ShaderCI.Macros = Macros;
+
+    RefCntAutoPtr<IShader> pVS;
+    {
+        ShaderCI.Desc.ShaderType = SHADER_TYPE_VERTEX;
+        ShaderCI.EntryPoint      = "main";
+        ShaderCI.Desc.Name       = "Debug draw VS";
+        ShaderCI.FilePath        = "debug_draw.vsh";
+        pDevice->CreateShader(ShaderCI, &pVS);
+    }
+
+    RefCntAutoPtr<IShader> pPS;
+    {
+        ShaderCI.Desc.ShaderType = SHADER_TYPE_PIXEL;
+        ShaderCI.EntryPoint      = "main";
+        ShaderCI.Desc.Name       = "Debug draw PS";
+        ShaderCI.FilePath        = "debug_draw.psh";
+        pDevice->CreateShader(ShaderCI, &pPS);
+    }
+
+    // clang-format off
+    LayoutElement LayoutElems[] =
+    {
+        // Attribute 0 - position
+        LayoutElement{0, 0, 3, VT_FLOAT32, False},
+        // Attribute 1 - color
+        LayoutElement{1, 0, 4, VT_UINT8, True}
+    };
+    // clang-format on
+
+    PSOCreateInfo.pVS = pVS;
+    PSOCreateInfo.pPS = pPS;
+    Features.SetSpecializationConstants(PSOCreateInfo);
+
+    PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = LayoutElems;
+    PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = _countof(LayoutElems);
+
+    PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+    pDevice->CreateGraphicsPipelineState(PSOCreateInfo, &m_pPSO);
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_VERTEX, "Constants")->Set(m_pConstants);
+    m_pPSO->CreateShaderResourceBinding(&m_pSRB, true);
+}
+
+Uint32 DebugDraw::PackColor(const float4& Color)
+{
+    auto ToUnorm8 = [](float f) {
+        return static_cast<Uint32>(clamp(f, 0.f, 1.f) * 255.f + 0.5f);
+    };
+    return ToUnorm8(Color.x) | (ToUnorm8(Color.y) << 8u) | (ToUnorm8(Color.z) << 16u) | (ToUnorm8(Color.w) << 24u);
+}
+
+void DebugDraw::Line(const float3& Start, const float3& End, const float4& Color)
+{
+    const Uint32 PackedColor = PackColor(Color);
+    m_Vertices.push_back({Start, PackedColor});
+    m_Vertices.push_back({End, PackedColor});
+}
+
+void DebugDraw::Box(const float4x4& Transform, const float4& Color)
+{
+    // clang-format off
+    static constexpr float CornerSigns[8][3] =
+    {
+        {-1, -1, -1}, {+1, -1, -1}, {+1, +1, -1}, {-1, +1, -1},
+        {-1, -1, +1}, {+1, -1, +1}, {+1, +1, +1}, {-1, +1, +1}
+    };
+    static constexpr Uint8 Edges[12][2] =
+    {
+        {0, 1}, {1, 2}, {2, 3}, {3, 0},
+        {4, 5}, {5, 6}, {6, 7}, {7, 4},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    // clang-format on
+
+    float3 Corners[8];
+    for (Uint32 i = 0; i < 8; ++i)
+    {
+        const float4 Pos = float4{CornerSigns[i][0], CornerSigns[i][1], CornerSigns[i][2], 1} * Transform;
+        Corners[i]       = float3{Pos.x, Pos.y, Pos.z};
+    }
+
+    const Uint32 PackedColor = PackColor(Color);
+    for (const auto& Edge : Edges)
+    {
+        m_Vertices.push_back({Corners[Edge[0]], PackedColor});
+        m_Vertices.push_back({Corners[Edge[1]], PackedColor});
+    }
+}
+
+void DebugDraw::AABB(const float3& Min, const float3& Max, const float4& Color)
+{
+    const float3 Center = (Min + Max) * 0.5f;
+    const float3 Extent = (Max - Min) * 0.5f;
+    Box(float4x4::Scale(Extent.x, Extent.y, Extent.z) * float4x4::Translation(Center.x, Center.y, Center.z), Color);
+}
+
+void DebugDraw::Axes(const float4x4& Transform, float Size)
+{
+    auto TransformPoint = [&Transform](float x, float y, float z) {
+        const float4 Pos = float4{x, y, z, 1} * Transform;
+        return float3{Pos.x, Pos.y, Pos.z};
+    };
+
+    const float3 Origin = TransformPoint(0, 0, 0);
+    Line(Origin, TransformPoint(Size, 0, 0), float4{1, 0, 0, 1});
+    Line(Origin, TransformPoint(0, Size, 0), float4{0, 1, 0, 1});
+    Line(Origin, TransformPoint(0, 0, Size), float4{0, 0, 1, 1});
+}
+
+void DebugDraw::Render(IDeviceContext* pContext, const float4x4& ViewProj)
+{
+    if (m_Vertices.empty())
+        return;
+
+    {
+        MapHelper<float4x4> CBConstants(pContext, m_pConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+        *CBConstants = ViewProj;
+    }
+
+    const Uint64 offset   = 0;
+    IBuffer*     pBuffs[] = {m_pVertexBuffer};
+    pContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+    pContext->SetPipelineState(m_pPSO);
+    pContext->CommitShaderResources(m_pSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    // The buffer is rewritten with DISCARD for every batch that does not fit
+    for (size_t FirstVertex = 0; FirstVertex < m_Vertices.size(); FirstVertex += m_MaxVertices)
+    {
+        const Uint32 NumVertices = static_cast<Uint32>(std::min(m_Vertices.size() - FirstVertex, size_t{m_MaxVertices}));
+        {
+            MapHelper<Vertex> Vertices(pContext, m_pVertexBuffer, MAP_WRITE, MAP_FLAG_DISCARD);
+            memcpy(Vertices, &m_Vertices[FirstVertex], NumVertices * sizeof(Vertex));
+        }
+
+        DrawAttribs DrawAttrs{NumVertices, DRAW_FLAG_VERIFY_ALL};
+        pContext->Draw(DrawAttrs);
+    }
+
+    m_Vertices.clear();
+}
+
+} // namespace Diligent
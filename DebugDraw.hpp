@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Immediate-mode renderer for debug overlays (lines, boxes, axes).
+//
+// Primitives are accumulated on the CPU during the frame and flushed by Render(), which
+// streams them into one dynamic vertex buffer and draws them as a line list with a single
+// draw call (or a few, if the number of vertices exceeds the buffer capacity).
+class DebugDraw
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice*                   pDevice                = nullptr;
+        IShaderSourceInputStreamFactory* pShaderSourceFactory   = nullptr;
+        TEXTURE_FORMAT                   RTVFormat              = TEX_FORMAT_UNKNOWN;
+        TEXTURE_FORMAT                   DSVFormat              = TEX_FORMAT_UNKNOWN;
+        bool                             ConvertPSOutputToGamma = false;
+
+        // Capacity of the streamed vertex buffer. Two vertices are used per line.
+        Uint32 MaxVertices = 65536;
+
+        // Optional cache the pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+
+        // Apply ConvertPSOutputToGamma as a specialization constant, see ShaderFeatures
+        bool UseSpecializationConstants = false;
+    };
+
+    explicit DebugDraw(const CreateInfo& CI);
+
+    void Line(const float3& Start, const float3& End, const float4& Color);
+
+    // Draws the edges of the [-1, 1] cube transformed by Transform
+    void Box(const float4x4& Transform, const float4& Color);
+
+    void AABB(const float3& Min, const float3& Max, const float4& Color);
+
+    // Draws X, Y and Z axes of the given space in red, green and blue
+    void Axes(const float4x4& Transform, float Size = 1);
+
+    // Draws all primitives accumulated since the last call and clears the list
+    void Render(IDeviceContext* pContext, const float4x4& ViewProj);
+
+    Uint32 GetNumPendingVertices() const { return static_cast<Uint32>(m_Vertices.size()); }
+
+private:
+    struct Vertex
+    {
+        float3 Pos;
+        Uint32 Color; // RGBA8
+    };
+
+    static Uint32 PackColor(const float4& Color);
+
+    const Uint32 m_MaxVertices;
+
+    RefCntAutoPtr<IPipelineState>         m_pPSO;
+    RefCntAutoPtr<IShaderResourceBinding> m_pSRB;
+    RefCntAutoPtr<IBuffer>                m_pVertexBuffer;
+    RefCntAutoPtr<IBuffer>                m_pConstants;
+
+    std::vector<Vertex> m_Vertices;
+};
+
+} // namespace Diligent
@@ -0,0 +1,176 @@
+#include "FrustumCulling.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "AdvancedMath.hpp"
+#include "Align.hpp"
+#include "WorkerPool.hpp"
+
+#if defined(__AVX__)
+#    include <immintrin.h>
+#    define FRUSTUM_CULLING_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define FRUSTUM_CULLING_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define FRUSTUM_CULLING_NEON 1
+#endif
+
+namespace Diligent
+{
+
+namespace
+{
+
+#if FRUSTUM_CULLING_AVX
+constexpr Uint32 SimdWidth = 8;
+#else
+constexpr Uint32 SimdWidth = 4;
+#endif
+
+// Smaller sets are culled on the calling thread, as waking up the workers costs more than culling them
+constexpr Uint32 MinParallelChunkSize = 4096;
+
+// Radius of padding spheres. No point is that far inside all planes.
+constexpr float CulledRadius = -FLT_MAX;
+
+// Returns a mask with bit N set if sphere N of the SimdWidth spheres that start at
+// the given pointers is inside or intersects all planes.
+inline Uint32 CullSpheres(const FrustumPlanes& Frustum, const float* pX, const float* pY, const float* pZ, const float* pR)
+{
+#if FRUSTUM_CULLING_AVX
+    const __m256 X    = _mm256_loadu_ps(pX);
+    const __m256 Y    = _mm256_loadu_ps(pY);
+    const __m256 Z    = _mm256_loadu_ps(pZ);
+    const __m256 NegR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(pR));
+
+    __m256 Inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const float4& Plane : Frustum.Planes)
+    {
+        __m256 Dist = _mm256_add_ps(_mm256_mul_ps(X, _mm256_set1_ps(Plane.x)), _mm256_set1_ps(Plane.w));
+        Dist        = _mm256_add_ps(Dist, _mm256_mul_ps(Y, _mm256_set1_ps(Plane.y)));
+        Dist        = _mm256_add_ps(Dist, _mm256_mul_ps(Z, _mm256_set1_ps(Plane.z)));
+        Inside      = _mm256_and_ps(Inside, _mm256_cmp_ps(Dist, NegR, _CMP_GE_OQ));
+    }
+    return static_cast<Uint32>(_mm256_movemask_ps(Inside));
+#elif FRUSTUM_CULLING_SSE
+    const __m128 X    = _mm_loadu_ps(pX);
+    const __m128 Y    = _mm_loadu_ps(pY);
+    const __m128 Z    = _mm_loadu_ps(pZ);
+    const __m128 NegR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(pR));
+
+    __m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const float4& Plane : Frustum.Planes)
+    {
+        __m128 Dist = _mm_add_ps(_mm_mul_ps(X, _mm_set1_ps(Plane.x)), _mm_set1_ps(Plane.w));
+        Dist        = _mm_add_ps(Dist, _mm_mul_ps(Y, _mm_set1_ps(Plane.y)));
+        Dist        = _mm_add_ps(Dist, _mm_mul_ps(Z, _mm_set1_ps(Plane.z)));
+        Inside      = _mm_and_ps(Inside, _mm_cmpge_ps(Dist, NegR));
+    }
+    return static_cast<Uint32>(_mm_movemask_ps(Inside));
+#elif FRUSTUM_CULLING_NEON
+    const float32x4_t X    = vld1q_f32(pX);
+    const float32x4_t Y    = vld1q_f32(pY);
+    const float32x4_t Z    = vld1q_f32(pZ);
+    const float32x4_t NegR = vnegq_f32(vld1q_f32(pR));
+
+    uint32x4_t Inside = vdupq_n_u32(~0u);
+    for (const float4& Plane : Frustum.Planes)
+    {
+        float32x4_t Dist = vmlaq_n_f32(vdupq_n_f32(Plane.w), X, Plane.x);
+        Dist             = vmlaq_n_f32(Dist, Y, Plane.y);
+        Dist             = vmlaq_n_f32(Dist, Z, Plane.z);
+        Inside           = vandq_u32(Inside, vcgeq_f32(Dist, NegR));
+    }
+
+    static const uint32_t LaneBits[] = {1, 2, 4, 8};
+    const uint32x4_t      Bits       = vandq_u32(Inside, vld1q_u32(LaneBits));
+    return vgetq_lane_u32(Bits, 0) | vgetq_lane_u32(Bits, 1) | vgetq_lane_u32(Bits, 2) | vgetq_lane_u32(Bits, 3);
+#else
+    Uint32 Mask = 0;
+    for (Uint32 i = 0; i < SimdWidth; ++i)
+    {
+        bool Inside = true;
+        for (const float4& Plane : Frustum.Planes)
+            Inside = Inside && (Plane.x * pX[i] + Plane.y * pY[i] + Plane.z * pZ[i] + Plane.w >= -pR[i]);
+        Mask |= (Inside ? 1u : 0u) << i;
+    }
+    return Mask;
+#endif
+}
+
+} // namespace
+
+FrustumPlanes ExtractFrustumPlanes(const float4x4& ViewProj, bool IsGL)
+{
+    ViewFrustum Frustum;
+    ExtractViewFrustumPlanesFromMatrix(ViewProj, Frustum, IsGL);
+
+    FrustumPlanes Planes;
+    for (Uint32 i = 0; i < ViewFrustum::NUM_PLANES; ++i)
+    {
+        const Plane3D& Plane  = Frustum.GetPlane(static_cast<ViewFrustum::PLANE_IDX>(i));
+        const float    InvLen = 1.f / length(Plane.Normal);
+
+        Planes.Planes[i] = float4{Plane.Normal * InvLen, Plane.Distance * InvLen};
+    }
+    return Planes;
+}
+
+void FrustumCuller::Resize(Uint32 NumSpheres)
+{
+    const Uint32 PaddedSize = AlignUp(NumSpheres, SimdWidth);
+    m_CenterX.resize(PaddedSize);
+    m_CenterY.resize(PaddedSize);
+    m_CenterZ.resize(PaddedSize);
+    m_Radius.resize(PaddedSize);
+
+    for (Uint32 i = std::min(m_NumSpheres, NumSpheres); i < PaddedSize; ++i)
+        SetSphere(i, float3{}, CulledRadius);
+
+    m_NumSpheres = NumSpheres;
+}
+
+void FrustumCuller::CullRange(const FrustumPlanes& Frustum, Uint32 Start, Uint32 End, std::vector<Uint32>& VisibleIds) const
+{
+    VisibleIds.clear();
+    // Start is aligned to the SIMD width, and the last group may only contain padding
+    // spheres past End.
+    for (Uint32 i = Start; i < End; i += SimdWidth)
+    {
+        Uint32 Mask = CullSpheres(Frustum, &m_CenterX[i], &m_CenterY[i], &m_CenterZ[i], &m_Radius[i]);
+        for (Uint32 Id = i; Mask != 0; ++Id, Mask >>= 1u)
+        {
+            if ((Mask & 1u) != 0)
+                VisibleIds.push_back(Id);
+        }
+    }
+}
+
+void FrustumCuller::Cull(const FrustumPlanes& Frustum, std::vector<Uint32>& VisibleIds, WorkerPool* pWorkers)
+{
+    const Uint32 NumThreads = pWorkers != nullptr ? pWorkers->GetNumThreads() : 1;
+    const Uint32 NumChunks  = std::max(1u, std::min(NumThreads, m_NumSpheres / MinParallelChunkSize));
+    if (NumChunks == 1)
+    {
+        CullRange(Frustum, 0, m_NumSpheres, VisibleIds);
+        return;
+    }
+
+    const Uint32 ChunkSize = AlignUp((m_NumSpheres + NumChunks - 1) / NumChunks, SimdWidth);
+    m_ChunkVisibleIds.resize(NumChunks);
+
+    // The first chunk writes to the output directly, the others are appended in order
+    pWorkers->Run(NumChunks, [&](Uint32 Chunk) {
+        const Uint32 Start = std::min(Chunk * ChunkSize, m_NumSpheres);
+        const Uint32 End   = std::min(Start + ChunkSize, m_NumSpheres);
+        CullRange(Frustum, Start, End, Chunk == 0 ? VisibleIds : m_ChunkVisibleIds[Chunk]);
+    });
+
+    for (Uint32 Chunk = 1; Chunk < NumChunks; ++Chunk)
+        VisibleIds.insert(VisibleIds.end(), m_ChunkVisibleIds[Chunk].begin(), m_ChunkVisibleIds[Chunk].end());
+}
+
+} // namespace Diligent
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// View frustum planes, normalized so that the signed distance of a point to a plane is
+// dot(Plane.xyz, Point) + Plane.w. Normals point inside the frustum.
+struct FrustumPlanes
+{
+    float4 Planes[6];
+};
+
+// Extracts the frustum planes from a view-projection matrix. OpenGL clip space depth
+// range is [-1, 1], which changes the near plane.
+FrustumPlanes ExtractFrustumPlanes(const float4x4& ViewProj, bool IsGL);
+
+
+class WorkerPool;
+
+// Tests bounding spheres against the view frustum on the CPU.
+//
+// Spheres are kept in structure-of-arrays form, so that one SIMD instruction tests 4 (SSE,
+// NEON) or 8 (AVX) spheres against a plane. Large sets are split into chunks that are culled
+// in parallel by a worker pool, and the result is a compact list of the indices of the
+// visible spheres.
+class FrustumCuller
+{
+public:
+    // Sets the number of spheres. New spheres are culled until they are set.
+    void Resize(Uint32 NumSpheres);
+
+    void SetSphere(Uint32 Index, const float3& Center, float Radius)
+    {
+        m_CenterX[Index] = Center.x;
+        m_CenterY[Index] = Center.y;
+        m_CenterZ[Index] = Center.z;
+        m_Radius[Index]  = Radius;
+    }
+
+    // Writes the indices of the spheres that intersect the frustum, in increasing order.
+    // Without a worker pool, all spheres are culled on the calling thread.
+    void Cull(const FrustumPlanes& Frustum, std::vector<Uint32>& VisibleIds, WorkerPool* pWorkers = nullptr);
+
+    Uint32 GetNumSpheres() const { return m_NumSpheres; }
+
+private:
+    void CullRange(const FrustumPlanes& Frustum, Uint32 Start, Uint32 End, std::vector<Uint32>& VisibleIds) const;
+
+    Uint32 m_NumSpheres = 0;
+
+    // Padded to a multiple of the SIMD width with spheres that are always culled
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_Radius;
+
+    // Results of the chunks other than the first one
+    std::vector<std::vector<Uint32>> m_ChunkVisibleIds;
+};
+
+} // namespace Diligent
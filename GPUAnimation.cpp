@@ -0,0 +1,122 @@
+#include "GPUAnimation.hpp"
+
+#include <algorithm>
+
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+#include "ShaderMacroHelper.hpp"
+
+namespace Diligent
+{
+
+GPUAnimation::Step GPUAnimation::Step::Rotate(const float3& Axis, float Speed, float Phase)
+{
+    Step Rot;
+    Rot.Vector = normalize(Axis);
+    Rot.Type   = STEP_TYPE_ROTATE;
+    Rot.Speed  = Speed;
+    Rot.Phase  = Phase;
+    return Rot;
+}
+
+GPUAnimation::Step GPUAnimation::Step::Translate(const float3& Offset)
+{
+    Step Trans;
+    Trans.Vector = Offset;
+    Trans.Type   = STEP_TYPE_TRANSLATE;
+    return Trans;
+}
+
+GPUAnimation::Step GPUAnimation::Step::Scale(const float3& Factors)
+{
+    Step Scl;
+    Scl.Vector = Factors;
+    Scl.Type   = STEP_TYPE_SCALE;
+    return Scl;
+}
+
+GPUAnimation::GPUAnimation(const CreateInfo& CI) :
+    m_MaxObjects{CI.MaxObjects},
+    m_MaxSteps{CI.MaxSteps}
+{
+    IRenderDevice* pDevice = CI.pDevice;
+
+    CreateUniformBuffer(pDevice, sizeof(Constants), "GPU animation constants CB", &m_pConstants);
+
+    BufferDesc BuffDesc;
+    BuffDesc.Name              = "GPU animation steps buffer";
+    BuffDesc.Usage             = USAGE_DEFAULT;
+    BuffDesc.BindFlags         = BIND_SHADER_RESOURCE;
+    BuffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+    BuffDesc.ElementByteStride = sizeof(Step);
+    BuffDesc.Size              = Uint64{m_MaxSteps} * sizeof(Step);
+    pDevice->CreateBuffer(BuffDesc, nullptr, &m_pStepsBuffer);
+
+    BuffDesc.Name              = "GPU animation objects buffer";
+    BuffDesc.ElementByteStride = sizeof(ObjectAnimation);
+    BuffDesc.Size              = Uint64{m_MaxObjects} * sizeof(ObjectAnimation);
+    pDevice->CreateBuffer(BuffDesc, nullptr, &m_pAnimationsBuffer);
+
+    ComputePipelineStateCreateInfo PSOCreateInfo;
+    PSOCreateInfo.PSODesc.Name         = "GPU animation PSO";
+    PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_COMPUTE;
+    PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+    ShaderMacroHelper Macros;
+    Macros.AddShaderMacro("THREAD_GROUP_SIZE", ThreadGroupSize);
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage             = SHADER_SOURCE_LANGUAGE_HLSL;
+    ShaderCI.CompileFlags               = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+    ShaderCI.pShaderSourceStreamFactory = CI.pShaderSourceFactory;
+    ShaderCI.Macros                     = Macros;
+
+    RefCntAutoPtr<IShader> pCS;
+    {
+        ShaderCI.Desc.ShaderType = SHADER_TYPE_COMPUTE;
+        ShaderCI.EntryPoint      = "main";
+        ShaderCI.Desc.Name       = "GPU animation CS";
+        ShaderCI.FilePath        = "gpu_animation.csh";
+        pDevice->CreateShader(ShaderCI, &pCS);
+    }
+    PSOCreateInfo.pCS = pCS;
+
+    PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+    pDevice->CreateComputePipelineState(PSOCreateInfo, &m_pPSO);
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "AnimationConstants")->Set(m_pConstants);
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Steps")->Set(m_pStepsBuffer->GetDefaultView(BUFFER_VIEW_SHADER_RESOURCE));
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Animations")->Set(m_pAnimationsBuffer->GetDefaultView(BUFFER_VIEW_SHADER_RESOURCE));
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Objects")->Set(CI.pObjectsUAV);
+    m_pPSO->CreateShaderResourceBinding(&m_pSRB, true);
+}
+
+void GPUAnimation::SetAnimations(IDeviceContext* pContext, const ObjectAnimation* pObjects, Uint32 NumObjects, const Step* pSteps, Uint32 NumSteps)
+{
+    VERIFY(NumSteps <= m_MaxSteps, "Too many animation steps");
+    NumSteps = std::min(NumSteps, m_MaxSteps);
+    if (NumSteps > 0)
+        pContext->UpdateBuffer(m_pStepsBuffer, 0, Uint64{NumSteps} * sizeof(Step), pSteps, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    m_NumObjects = std::min(NumObjects, m_MaxObjects);
+    if (m_NumObjects > 0)
+        pContext->UpdateBuffer(m_pAnimationsBuffer, 0, Uint64{m_NumObjects} * sizeof(ObjectAnimation), pObjects, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+}
+
+void GPUAnimation::Update(IDeviceContext* pContext, float Time)
+{
+    if (m_NumObjects == 0)
+        return;
+
+    {
+        MapHelper<Constants> CBConstants(pContext, m_pConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+        CBConstants->Time       = Time;
+        CBConstants->NumObjects = m_NumObjects;
+    }
+
+    pContext->SetPipelineState(m_pPSO);
+    pContext->CommitShaderResources(m_pSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    pContext->DispatchCompute(DispatchComputeAttribs{(m_NumObjects + ThreadGroupSize - 1) / ThreadGroupSize});
+}
+
+} // namespace Diligent
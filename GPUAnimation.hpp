@@ -0,0 +1,104 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Evaluates procedural object animation on the GPU.
+//
+// The animation of every object is a constant local transform followed by a list of steps:
+// rotations whose angle is a linear function of time, translations and scales. Spins and
+// orbits are rotations, orbit radii and offsets are translations, and a parent is added by
+// appending the steps of the parent. Steps and objects are uploaded once. Every frame a
+// compute pass evaluates the steps at the time of the frame and writes the world transforms
+// to the object records of the GPU scene, so the only per-frame upload is the time.
+class GPUAnimation
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice*                   pDevice              = nullptr;
+        IShaderSourceInputStreamFactory* pShaderSourceFactory = nullptr;
+
+        // Unordered access view of the GPU scene object records
+        IBufferView* pObjectsUAV = nullptr;
+
+        Uint32 MaxObjects = 16384;
+        Uint32 MaxSteps   = 256;
+
+        // Optional cache the pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+    };
+
+    // Must match ANIMATION_STEP_* in gpu_animation.csh
+    enum STEP_TYPE : Uint32
+    {
+        // Rotation about the Vector axis by Speed * Time + Phase radians
+        STEP_TYPE_ROTATE = 0,
+
+        // Translation by Vector
+        STEP_TYPE_TRANSLATE,
+
+        // Scale by Vector
+        STEP_TYPE_SCALE
+    };
+
+    // Must match AnimationStep in gpu_animation.csh
+    struct Step
+    {
+        float3    Vector;
+        STEP_TYPE Type       = STEP_TYPE_TRANSLATE;
+        float     Speed      = 0;
+        float     Phase      = 0;
+        Uint32    Padding[2] = {};
+
+        static Step Rotate(const float3& Axis, float Speed, float Phase = 0);
+        static Step Translate(const float3& Offset);
+        static Step Scale(const float3& Factors);
+    };
+
+    // Must match ObjectAnimation in gpu_animation.csh
+    struct ObjectAnimation
+    {
+        float4x4 Local;
+        // Steps applied after the local transform, in order
+        Uint32   FirstStep  = 0;
+        Uint32   NumSteps   = 0;
+        Uint32   Padding[2] = {};
+    };
+
+    explicit GPUAnimation(const CreateInfo& CI);
+
+    // Uploads the animations. Animation N writes the world transform of object record N.
+    // Objects and steps beyond the maximum counts are ignored.
+    void SetAnimations(IDeviceContext* pContext, const ObjectAnimation* pObjects, Uint32 NumObjects, const Step* pSteps, Uint32 NumSteps);
+
+    // Runs the compute pass that writes the world transforms at the given time
+    void Update(IDeviceContext* pContext, float Time);
+
+private:
+    struct Constants
+    {
+        float  Time       = 0;
+        Uint32 NumObjects = 0;
+        Uint32 Padding[2] = {};
+    };
+
+    static constexpr Uint32 ThreadGroupSize = 64;
+
+    const Uint32 m_MaxObjects;
+    const Uint32 m_MaxSteps;
+    Uint32       m_NumObjects = 0;
+
+    RefCntAutoPtr<IBuffer>                m_pConstants;
+    RefCntAutoPtr<IBuffer>                m_pStepsBuffer;
+    RefCntAutoPtr<IBuffer>                m_pAnimationsBuffer;
+    RefCntAutoPtr<IPipelineState>         m_pPSO;
+    RefCntAutoPtr<IShaderResourceBinding> m_pSRB;
+};
+
+} // namespace Diligent
@@ -0,0 +1,339 @@
+#include "GPUScene.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+#include "ShaderMacroHelper.hpp"
+#include "FrustumCulling.hpp"
+
+namespace Diligent
+{
+
+bool GPUScene::IsSupported(IRenderDevice* pDevice)
+{
+    const DeviceFeatures&        Features = pDevice->GetDeviceInfo().Features;
+    const DRAW_COMMAND_CAP_FLAGS CapFlags = pDevice->GetAdapterInfo().DrawCommand.CapFlags;
+    // clang-format off
+    return Features.ComputeShaders    != DEVICE_FEATURE_STATE_DISABLED &&
+           Features.IndirectRendering != DEVICE_FEATURE_STATE_DISABLED &&
+           (CapFlags & DRAW_COMMAND_CAP_FLAG_DRAW_INDIRECT_FIRST_INSTANCE) != 0;
+    // clang-format on
+}
+
+GPUScene::GPUScene(const CreateInfo& CI) :
+    m_MaxObjects{CI.MaxObjects},
+    // Patches are padded to whole thread groups
+    m_MaxPatches{(CI.MaxPatches + ThreadGroupSize - 1) / ThreadGroupSize * ThreadGroupSize},
+    m_IsGL{CI.pDevice->GetDeviceInfo().IsGLDevice()}
+{
+    IRenderDevice* pDevice = CI.pDevice;
+
+    const DrawCommandProperties& DrawCommand = pDevice->GetAdapterInfo().DrawCommand;
+    if ((DrawCommand.CapFlags & DRAW_COMMAND_CAP_FLAG_NATIVE_MULTI_DRAW_INDIRECT) != 0 && DrawCommand.MaxDrawIndirectCount >= m_MaxObjects)
+    {
+        m_DrawMode = (DrawCommand.CapFlags & DRAW_COMMAND_CAP_FLAG_DRAW_INDIRECT_COUNTER_BUFFER) != 0 ?
+            DRAW_MODE_INDIRECT_COUNT :
+            DRAW_MODE_MULTI_DRAW;
+    }
+    const bool CompactDraws = m_DrawMode == DRAW_MODE_INDIRECT_COUNT;
+
+    CreateUniformBuffer(pDevice, sizeof(SceneConstants), "GPU scene constants CB", &m_pConstants);
+
+    BufferDesc BuffDesc;
+    BuffDesc.Name              = "GPU scene objects buffer";
+    BuffDesc.Usage             = USAGE_DEFAULT;
+    // World transforms can be written by a compute pass that animates the objects
+    BuffDesc.BindFlags         = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+    BuffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+    BuffDesc.ElementByteStride = sizeof(ObjectData);
+    BuffDesc.Size              = Uint64{m_MaxObjects} * sizeof(ObjectData);
+    pDevice->CreateBuffer(BuffDesc, nullptr, &m_pObjectsBuffer);
+    m_pObjectsSRV = m_pObjectsBuffer->GetDefaultView(BUFFER_VIEW_SHADER_RESOURCE);
+    m_pObjectsUAV = m_pObjectsBuffer->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS);
+
+    // Indirect argument buffers are written by the compute pass as raw buffers
+    BuffDesc.Name              = "GPU scene draw args buffer";
+    BuffDesc.BindFlags         = BIND_UNORDERED_ACCESS | BIND_INDIRECT_DRAW_ARGS;
+    BuffDesc.Mode              = BUFFER_MODE_RAW;
+    BuffDesc.ElementByteStride = sizeof(Uint32);
+    BuffDesc.Size              = Uint64{m_MaxObjects} * DrawArgsStride;
+    pDevice->CreateBuffer(BuffDesc, nullptr, &m_pDrawArgsBuffer);
+
+    if (CompactDraws)
+    {
+        BuffDesc.Name = "GPU scene draw count buffer";
+        // Raw views require the size to be a multiple of 16 bytes
+        BuffDesc.Size = sizeof(Uint32) * 4;
+        pDevice->CreateBuffer(BuffDesc, nullptr, &m_pDrawCountBuffer);
+    }
+
+    {
+        // Objects start hidden, so in the first frame the occlusion phase tests all of them
+        const std::vector<Uint32> Visibility(m_MaxObjects, 0);
+
+        BuffDesc.Name              = "GPU scene visibility buffer";
+        BuffDesc.BindFlags         = BIND_UNORDERED_ACCESS;
+        BuffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+        BuffDesc.ElementByteStride = sizeof(Uint32);
+        BuffDesc.Size              = Uint64{m_MaxObjects} * sizeof(Uint32);
+
+        BufferData InitData;
+        InitData.pData    = Visibility.data();
+        InitData.DataSize = BuffDesc.Size;
+        pDevice->CreateBuffer(BuffDesc, &InitData, &m_pVisibilityBuffer);
+    }
+
+    BuffDesc.Name              = "GPU scene patch buffer";
+    BuffDesc.BindFlags         = BIND_SHADER_RESOURCE;
+    BuffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+    BuffDesc.ElementByteStride = sizeof(ObjectPatch);
+    BuffDesc.Size              = Uint64{m_MaxPatches} * sizeof(ObjectPatch);
+    pDevice->CreateBuffer(BuffDesc, nullptr, &m_pPatchBuffer);
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage             = SHADER_SOURCE_LANGUAGE_HLSL;
+    ShaderCI.CompileFlags               = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+    ShaderCI.pShaderSourceStreamFactory = CI.pShaderSourceFactory;
+
+    static constexpr const char* PSONames[] = {"GPU scene draw args PSO", "GPU scene draw args PSO (previously visible)", "GPU scene draw args PSO (occlusion)"};
+    static_assert(_countof(PSONames) == CULL_PHASE_COUNT, "Please update the PSO names");
+    for (Uint32 Phase = 0; Phase < CULL_PHASE_COUNT; ++Phase)
+    {
+        ComputePipelineStateCreateInfo PSOCreateInfo;
+        PSOCreateInfo.PSODesc.Name         = PSONames[Phase];
+        PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_COMPUTE;
+        PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+        // OpenGL clip space has Y pointing up in texture space and depth in [-1, 1]
+        ShaderMacroHelper Macros;
+        Macros.AddShaderMacro("THREAD_GROUP_SIZE", ThreadGroupSize);
+        Macros.AddShaderMacro("COMPACT_DRAWS", CompactDraws ? 1 : 0);
+        Macros.AddShaderMacro("CULL_PHASE", Phase);
+        Macros.AddShaderMacro("NDC_UV_FLIP_Y", m_IsGL ? 0 : 1);
+        Macros.AddShaderMacro("NDC_DEPTH_NEGATIVE_ONE_TO_ONE", m_IsGL ? 1 : 0);
+        ShaderCI.Macros = Macros;
+
+        RefCntAutoPtr<IShader> pCS;
+        {
+            ShaderCI.Desc.ShaderType = SHADER_TYPE_COMPUTE;
+            ShaderCI.EntryPoint      = "main";
+            ShaderCI.Desc.Name       = "GPU scene draw args CS";
+            ShaderCI.FilePath        = "gpu_draw_args.csh";
+            pDevice->CreateShader(ShaderCI, &pCS);
+        }
+        PSOCreateInfo.pCS = pCS;
+
+        PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        // The pyramid is recreated when the window is resized
+        ShaderResourceVariableDesc Vars[] =
+            {
+                {SHADER_TYPE_COMPUTE, "g_HiZ", SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE},
+            };
+        if (Phase == CULL_PHASE_OCCLUSION)
+        {
+            PSOCreateInfo.PSODesc.ResourceLayout.Variables    = Vars;
+            PSOCreateInfo.PSODesc.ResourceLayout.NumVariables = _countof(Vars);
+        }
+
+        RefCntAutoPtr<IPipelineState>& pPSO = m_pDrawArgsPSOs[Phase];
+        pDevice->CreateComputePipelineState(PSOCreateInfo, &pPSO);
+        pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "SceneConstants")->Set(m_pConstants);
+        pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Objects")->Set(m_pObjectsSRV);
+        pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_DrawArgs")->Set(m_pDrawArgsBuffer->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS));
+        if (CompactDraws)
+            pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_DrawCount")->Set(m_pDrawCountBuffer->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS));
+        if (Phase != CULL_PHASE_NONE)
+            pPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Visibility")->Set(m_pVisibilityBuffer->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS));
+        pPSO->CreateShaderResourceBinding(&m_pDrawArgsSRBs[Phase], true);
+    }
+
+    {
+        ComputePipelineStateCreateInfo PSOCreateInfo;
+        PSOCreateInfo.PSODesc.Name         = "GPU scene scatter PSO";
+        PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_COMPUTE;
+        PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+        ShaderMacroHelper Macros;
+        Macros.AddShaderMacro("THREAD_GROUP_SIZE", ThreadGroupSize);
+        ShaderCI.Macros = Macros;
+
+        RefCntAutoPtr<IShader> pCS;
+        {
+            ShaderCI.Desc.ShaderType = SHADER_TYPE_COMPUTE;
+            ShaderCI.EntryPoint      = "main";
+            ShaderCI.Desc.Name       = "GPU scene scatter CS";
+            ShaderCI.FilePath        = "gpu_scene_scatter.csh";
+            pDevice->CreateShader(ShaderCI, &pCS);
+        }
+        PSOCreateInfo.pCS = pCS;
+
+        PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        pDevice->CreateComputePipelineState(PSOCreateInfo, &m_pScatterPSO);
+        m_pScatterPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Patches")->Set(m_pPatchBuffer->GetDefaultView(BUFFER_VIEW_SHADER_RESOURCE));
+        m_pScatterPSO->GetStaticVariableByName(SHADER_TYPE_COMPUTE, "g_Objects")->Set(m_pObjectsUAV);
+        m_pScatterPSO->CreateShaderResourceBinding(&m_pScatterSRB, true);
+    }
+}
+
+const char* GPUScene::GetDrawModeName() const
+{
+    switch (m_DrawMode)
+    {
+        case DRAW_MODE_INDIRECT_COUNT: return "Multi-draw indirect count";
+        case DRAW_MODE_MULTI_DRAW: return "Multi-draw indirect";
+        case DRAW_MODE_LOOP: return "Indirect draw loop";
+        default: return "Unknown";
+    }
+}
+
+void GPUScene::UploadAllObjects(IDeviceContext* pContext, const ObjectData* pObjects)
+{
+    if (m_NumObjects > 0)
+    {
+        const Uint64 RangeSize = Uint64{m_NumObjects} * sizeof(ObjectData);
+        pContext->UpdateBuffer(m_pObjectsBuffer, 0, RangeSize, pObjects, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_LastUploadSize = RangeSize;
+    }
+    m_UploadedObjects.assign(pObjects, pObjects + m_NumObjects);
+}
+
+void GPUScene::SetObjects(IDeviceContext* pContext, const ObjectData* pObjects, Uint32 NumObjects)
+{
+    m_NumObjects     = std::min(NumObjects, m_MaxObjects);
+    m_LastUploadSize = 0;
+    UploadAllObjects(pContext, pObjects);
+}
+
+void GPUScene::UpdateObjects(IDeviceContext* pContext, const ObjectData* pObjects, const Uint32* pObjectIds, Uint32 NumObjectIds)
+{
+    m_LastUploadSize = 0;
+
+    // The records were written on the GPU, so the copies can not tell what changed
+    if (m_UploadedObjects.size() != m_NumObjects)
+    {
+        UploadAllObjects(pContext, pObjects);
+        return;
+    }
+
+    // Listed records are patched if they changed. If too many of them did, one upload
+    // of the whole range is cheaper than the patches.
+    m_Patches.clear();
+    for (Uint32 i = 0; i < NumObjectIds; ++i)
+    {
+        const Uint32 ObjectIndex = pObjectIds[i];
+        if (ObjectIndex >= m_NumObjects)
+            continue;
+
+        ObjectData& Uploaded = m_UploadedObjects[ObjectIndex];
+        if (memcmp(&pObjects[ObjectIndex], &Uploaded, sizeof(ObjectData)) == 0)
+            continue;
+
+        if (m_Patches.size() == m_MaxPatches)
+        {
+            m_Patches.clear();
+            UploadAllObjects(pContext, pObjects);
+            return;
+        }
+
+        Uploaded = pObjects[ObjectIndex];
+
+        ObjectPatch Patch;
+        Patch.ObjectIndex = ObjectIndex;
+        Patch.Data        = Uploaded;
+        m_Patches.push_back(Patch);
+    }
+
+    if (m_Patches.empty())
+        return;
+
+    // The last patch is repeated to fill the last thread group. Writing the
+    // same record more than once gives the same result.
+    const size_t NumPatches = m_Patches.size();
+    m_Patches.resize((NumPatches + ThreadGroupSize - 1) / ThreadGroupSize * ThreadGroupSize, m_Patches.back());
+
+    const Uint64 PatchesSize = Uint64{m_Patches.size()} * sizeof(ObjectPatch);
+    pContext->UpdateBuffer(m_pPatchBuffer, 0, PatchesSize, m_Patches.data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    m_LastUploadSize = PatchesSize;
+
+    pContext->SetPipelineState(m_pScatterPSO);
+    pContext->CommitShaderResources(m_pScatterSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    pContext->DispatchCompute(DispatchComputeAttribs{static_cast<Uint32>(m_Patches.size()) / ThreadGroupSize});
+}
+
+void GPUScene::SetView(IDeviceContext* pContext, const float4x4& ViewProj, bool FrustumCulling)
+{
+    MapHelper<SceneConstants> Constants(pContext, m_pConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+    Constants->ViewProj       = ViewProj;
+    Constants->NumObjects     = m_NumObjects;
+    Constants->FrustumCulling = FrustumCulling ? 1 : 0;
+
+    const FrustumPlanes Frustum = ExtractFrustumPlanes(ViewProj, m_IsGL);
+    for (Uint32 i = 0; i < _countof(Frustum.Planes); ++i)
+        Constants->FrustumPlanes[i] = Frustum.Planes[i];
+}
+
+void GPUScene::GenerateDraws(IDeviceContext* pContext, CULL_PHASE Phase, ITextureView* pHiZSRV)
+{
+    if (m_NumObjects == 0)
+        return;
+
+    if (Phase == CULL_PHASE_OCCLUSION)
+    {
+        VERIFY(pHiZSRV != nullptr, "Occlusion phase requires the Hi-Z pyramid");
+        m_pDrawArgsSRBs[Phase]->GetVariableByName(SHADER_TYPE_COMPUTE, "g_HiZ")->Set(pHiZSRV);
+    }
+
+    if (m_pDrawCountBuffer)
+    {
+        const Uint32 Zero = 0;
+        pContext->UpdateBuffer(m_pDrawCountBuffer, 0, sizeof(Zero), &Zero, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+
+    pContext->SetPipelineState(m_pDrawArgsPSOs[Phase]);
+    pContext->CommitShaderResources(m_pDrawArgsSRBs[Phase], RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    pContext->DispatchCompute(DispatchComputeAttribs{(m_NumObjects + ThreadGroupSize - 1) / ThreadGroupSize});
+}
+
+void GPUScene::Draw(IDeviceContext* pContext) const
+{
+    if (m_NumObjects == 0)
+        return;
+
+    DrawIndexedIndirectAttribs DrawAttrs;
+    DrawAttrs.pAttribsBuffer                   = m_pDrawArgsBuffer;
+    DrawAttrs.IndexType                        = VT_UINT32;
+    DrawAttrs.DrawArgsStride                   = DrawArgsStride;
+    DrawAttrs.Flags                            = DRAW_FLAG_VERIFY_ALL;
+    DrawAttrs.AttribsBufferStateTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+
+    switch (m_DrawMode)
+    {
+        case DRAW_MODE_INDIRECT_COUNT:
+            // DrawCount is the upper bound; the actual count is read from the counter buffer
+            DrawAttrs.DrawCount                        = m_NumObjects;
+            DrawAttrs.pCounterBuffer                   = m_pDrawCountBuffer;
+            DrawAttrs.CounterBufferStateTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+            pContext->DrawIndexedIndirect(DrawAttrs);
+            break;
+
+        case DRAW_MODE_MULTI_DRAW:
+            DrawAttrs.DrawCount = m_NumObjects;
+            pContext->DrawIndexedIndirect(DrawAttrs);
+            break;
+
+        case DRAW_MODE_LOOP:
+            for (Uint32 i = 0; i < m_NumObjects; ++i)
+            {
+                DrawAttrs.DrawArgsOffset = Uint64{i} * DrawArgsStride;
+                pContext->DrawIndexedIndirect(DrawAttrs);
+            }
+            break;
+    }
+}
+
+} // namespace Diligent
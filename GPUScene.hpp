@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Generates the draw commands of the scene on the GPU.
+//
+// Every object is described by an ObjectData record in a structured buffer. A compute pass
+// tests the bounding sphere of every object against the view frustum and writes the
+// DrawIndexedIndirect arguments of the visible ones. The scene is then drawn with a
+// single multi-draw-indirect call whose draw count is read from a GPU buffer. Devices that
+// cannot read the count from a buffer issue one draw per object record instead, and culled
+// objects get empty draws.
+//
+// Occlusion culling runs in two phases. The first phase draws the objects that were visible
+// in the previous frame. A Hi-Z pyramid is built from the resulting depth, and the second
+// phase tests all objects against it, draws the visible ones that the first phase missed,
+// and records visibility for the next frame.
+//
+// Every draw uses the index of its object as FirstInstanceLocation, so a per-instance draw
+// id attribute that starts at FirstInstanceLocation gives the vertex shader its object.
+//
+// Object records persist on the GPU between frames. The caller lists the objects it changed,
+// and only their records are sent, as patches that a compute pass scatters into the buffer.
+class GPUScene
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice*                   pDevice              = nullptr;
+        IShaderSourceInputStreamFactory* pShaderSourceFactory = nullptr;
+
+        Uint32 MaxObjects = 16384;
+
+        // Maximum number of records patched in one UpdateObjects() call. If more of them
+        // change, the whole buffer is uploaded instead.
+        Uint32 MaxPatches = 4096;
+
+        // Optional cache the pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+    };
+
+    // Must match ObjectData in gpu_scene.fxh
+    struct ObjectData
+    {
+        float4x4 World;
+        // xyz - center in object space, w - radius
+        float4   BoundingSphere;
+        Uint32   FirstIndexLocation = 0;
+        Uint32   NumIndices         = 0;
+        Uint32   BaseVertex         = 0;
+        // Layout of the pulled vertices, see GeometryPool::MeshHandle
+        Uint32   VertexFormat       = 0;
+        Uint32   VertexBase         = 0;
+        Uint32   Padding[3]         = {};
+    };
+
+    // Must match CULL_PHASE_* in gpu_draw_args.csh
+    enum CULL_PHASE : Uint32
+    {
+        // All objects that pass the frustum test are drawn
+        CULL_PHASE_NONE = 0,
+
+        // Objects that were visible in the previous frame are drawn
+        CULL_PHASE_PREVIOUSLY_VISIBLE,
+
+        // Objects are tested against the Hi-Z pyramid built after the first phase
+        CULL_PHASE_OCCLUSION,
+
+        CULL_PHASE_COUNT
+    };
+
+    static bool IsSupported(IRenderDevice* pDevice);
+
+    explicit GPUScene(const CreateInfo& CI);
+
+    // Uploads all object records. Objects beyond GetMaxObjects() are ignored.
+    void SetObjects(IDeviceContext* pContext, const ObjectData* pObjects, Uint32 NumObjects);
+
+    // Uploads the records of the listed objects that differ from the ones on the GPU.
+    // pObjects holds the records of all objects set by the last SetObjects() call, but only
+    // the listed ones are read, unless the records were invalidated or too many of them
+    // changed, in which case all of them are uploaded.
+    void UpdateObjects(IDeviceContext* pContext, const ObjectData* pObjects, const Uint32* pObjectIds, Uint32 NumObjectIds);
+
+    // Must be called when the records are written on the GPU, so that the next
+    // UpdateObjects() call uploads all of them
+    void InvalidateObjects() { m_UploadedObjects.clear(); }
+
+    // Updates the scene constants. Must be called after SetObjects().
+    // If FrustumCulling is false, objects outside of the frustum are not culled.
+    void SetView(IDeviceContext* pContext, const float4x4& ViewProj, bool FrustumCulling);
+
+    // Runs the compute pass that writes the draw arguments for the given culling phase.
+    // The occlusion phase reads the Hi-Z pyramid built from the depth of the first phase.
+    void GenerateDraws(IDeviceContext* pContext, CULL_PHASE Phase = CULL_PHASE_NONE, ITextureView* pHiZSRV = nullptr);
+
+    // Issues the draws generated by the last GenerateDraws() call. Pipeline state, shader
+    // resources, vertex and index buffers must be set by the caller.
+    void Draw(IDeviceContext* pContext) const;
+
+    // Scene constants and object records, read by the vertex shaders of the path
+    IBuffer*     GetConstantsBuffer() const { return m_pConstants; }
+    IBufferView* GetObjectsSRV() const { return m_pObjectsSRV; }
+    IBufferView* GetObjectsUAV() const { return m_pObjectsUAV; }
+
+    Uint32      GetMaxObjects() const { return m_MaxObjects; }
+    // Number of bytes sent by the last SetObjects() or UpdateObjects() call
+    Uint64      GetLastUploadSize() const { return m_LastUploadSize; }
+    const char* GetDrawModeName() const;
+
+private:
+    // Uploads the first m_NumObjects records as one range
+    void UploadAllObjects(IDeviceContext* pContext, const ObjectData* pObjects);
+
+    enum DRAW_MODE
+    {
+        // One multi-draw with the count read from the counter buffer
+        DRAW_MODE_INDIRECT_COUNT,
+
+        // One multi-draw over all object slots
+        DRAW_MODE_MULTI_DRAW,
+
+        // One indirect draw per object slot
+        DRAW_MODE_LOOP
+    };
+
+    struct SceneConstants
+    {
+        float4x4 ViewProj;
+        float4   FrustumPlanes[6];
+        Uint32   NumObjects     = 0;
+        Uint32   FrustumCulling = 0;
+        Uint32   Padding[2]     = {};
+    };
+
+    // Must match ObjectPatch in gpu_scene_scatter.csh
+    struct ObjectPatch
+    {
+        Uint32     ObjectIndex = 0;
+        Uint32     Padding[3]  = {};
+        ObjectData Data;
+    };
+
+    static constexpr Uint32 DrawArgsStride  = sizeof(Uint32) * 5;
+    static constexpr Uint32 ThreadGroupSize = 64;
+
+    const Uint32 m_MaxObjects;
+    const Uint32 m_MaxPatches;
+    // OpenGL clip space depth range is [-1, 1], which changes the near plane
+    const bool m_IsGL;
+    DRAW_MODE    m_DrawMode   = DRAW_MODE_LOOP;
+    Uint32       m_NumObjects = 0;
+
+    // Records as they were last uploaded, and the patches of the current upload
+    std::vector<ObjectData>  m_UploadedObjects;
+    std::vector<ObjectPatch> m_Patches;
+    Uint64                   m_LastUploadSize = 0;
+
+    RefCntAutoPtr<IBuffer>     m_pConstants;
+    RefCntAutoPtr<IBuffer>     m_pObjectsBuffer;
+    RefCntAutoPtr<IBufferView> m_pObjectsSRV;
+    RefCntAutoPtr<IBufferView> m_pObjectsUAV;
+    RefCntAutoPtr<IBuffer>     m_pDrawArgsBuffer;
+    RefCntAutoPtr<IBuffer>     m_pDrawCountBuffer;
+    RefCntAutoPtr<IBuffer>     m_pVisibilityBuffer;
+    RefCntAutoPtr<IBuffer>     m_pPatchBuffer;
+
+    RefCntAutoPtr<IPipelineState>         m_pDrawArgsPSOs[CULL_PHASE_COUNT];
+    RefCntAutoPtr<IShaderResourceBinding> m_pDrawArgsSRBs[CULL_PHASE_COUNT];
+    RefCntAutoPtr<IPipelineState>         m_pScatterPSO;
+    RefCntAutoPtr<IShaderResourceBinding> m_pScatterSRB;
+};
+
+} // namespace Diligent
@@ -0,0 +1,195 @@
+#include "GeometryPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+GeometryPool::RangeAllocator::RangeAllocator(Uint32 Size)
+{
+    m_FreeRanges.push_back({0, Size});
+}
+
+Uint32 GeometryPool::RangeAllocator::Allocate(Uint32 Size)
+{
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+    {
+        if (it->Size < Size)
+            continue;
+
+        const Uint32 Offset = it->Offset;
+        it->Offset += Size;
+        it->Size -= Size;
+        if (it->Size == 0)
+            m_FreeRanges.erase(it);
+        return Offset;
+    }
+    return InvalidOffset;
+}
+
+void GeometryPool::RangeAllocator::Free(Uint32 Offset, Uint32 Size)
+{
+    auto Next = std::lower_bound(m_FreeRanges.begin(), m_FreeRanges.end(), Offset,
+                                 [](const Range& R, Uint32 Off) { return R.Offset < Off; });
+
+    const bool MergeWithPrev = Next != m_FreeRanges.begin() && std::prev(Next)->Offset + std::prev(Next)->Size == Offset;
+    const bool MergeWithNext = Next != m_FreeRanges.end() && Offset + Size == Next->Offset;
+    if (MergeWithPrev && MergeWithNext)
+    {
+        std::prev(Next)->Size += Size + Next->Size;
+        m_FreeRanges.erase(Next);
+    }
+    else if (MergeWithPrev)
+    {
+        std::prev(Next)->Size += Size;
+    }
+    else if (MergeWithNext)
+    {
+        Next->Offset = Offset;
+        Next->Size += Size;
+    }
+    else
+    {
+        m_FreeRanges.insert(Next, {Offset, Size});
+    }
+}
+
+
+GeometryPool::GeometryPool(const CreateInfo& CI) :
+    // clang-format off
+    m_BaseVertexSupported{CI.BaseVertexSupported},
+    m_VertexAllocator    {CI.MaxVertices},
+    m_IndexAllocator     {CI.MaxIndices}
+// clang-format on
+{
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name      = "Geometry pool vertex buffer";
+    VertBuffDesc.Usage     = USAGE_DEFAULT;
+    VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
+    VertBuffDesc.Size      = Uint64{CI.MaxVertices} * sizeof(MeshVertex);
+    if (CI.ShaderResourceVertices)
+    {
+        // Structured buffers cannot be bound as vertex buffers in D3D11, but formatted ones can
+        VertBuffDesc.BindFlags         = BIND_VERTEX_BUFFER | BIND_SHADER_RESOURCE;
+        VertBuffDesc.Mode              = BUFFER_MODE_FORMATTED;
+        VertBuffDesc.ElementByteStride = sizeof(float);
+    }
+    CI.pDevice->CreateBuffer(VertBuffDesc, nullptr, &m_pVertexBuffer);
+
+    if (CI.ShaderResourceVertices)
+    {
+        BufferViewDesc ViewDesc;
+        ViewDesc.Name                 = "Geometry pool vertex buffer SRV";
+        ViewDesc.ViewType             = BUFFER_VIEW_SHADER_RESOURCE;
+        ViewDesc.Format.ValueType     = VT_FLOAT32;
+        ViewDesc.Format.NumComponents = 1;
+        m_pVertexBuffer->CreateView(ViewDesc, &m_pVertexBufferSRV);
+    }
+
+    if (CI.PositionStream)
+    {
+        BufferDesc PosBuffDesc;
+        PosBuffDesc.Name      = "Geometry pool position buffer";
+        PosBuffDesc.Usage     = USAGE_DEFAULT;
+        PosBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
+        PosBuffDesc.Size      = Uint64{CI.MaxVertices} * sizeof(float3);
+        if (CI.ShaderResourceVertices)
+        {
+            PosBuffDesc.BindFlags         = BIND_VERTEX_BUFFER | BIND_SHADER_RESOURCE;
+            PosBuffDesc.Mode              = BUFFER_MODE_FORMATTED;
+            PosBuffDesc.ElementByteStride = sizeof(float);
+        }
+        CI.pDevice->CreateBuffer(PosBuffDesc, nullptr, &m_pPositionBuffer);
+
+        if (CI.ShaderResourceVertices)
+        {
+            BufferViewDesc ViewDesc;
+            ViewDesc.Name                 = "Geometry pool position buffer SRV";
+            ViewDesc.ViewType             = BUFFER_VIEW_SHADER_RESOURCE;
+            ViewDesc.Format.ValueType     = VT_FLOAT32;
+            ViewDesc.Format.NumComponents = 1;
+            m_pPositionBuffer->CreateView(ViewDesc, &m_pPositionBufferSRV);
+        }
+    }
+
+    BufferDesc IndBuffDesc;
+    IndBuffDesc.Name      = "Geometry pool index buffer";
+    IndBuffDesc.Usage     = USAGE_DEFAULT;
+    IndBuffDesc.BindFlags = BIND_INDEX_BUFFER;
+    IndBuffDesc.Size      = Uint64{CI.MaxIndices} * sizeof(Uint32);
+    CI.pDevice->CreateBuffer(IndBuffDesc, nullptr, &m_pIndexBuffer);
+}
+
+GeometryPool::MeshHandle GeometryPool::Allocate(IDeviceContext* pContext, const MeshData& Mesh)
+{
+    VERIFY_EXPR(Mesh.NumVertices > 0 && Mesh.NumIndices > 0);
+
+    const Uint32 FirstVertex = m_VertexAllocator.Allocate(Mesh.NumVertices);
+    if (FirstVertex == RangeAllocator::InvalidOffset)
+    {
+        LOG_ERROR_MESSAGE("Geometry pool is out of vertex space");
+        return {};
+    }
+
+    const Uint32 FirstIndex = m_IndexAllocator.Allocate(Mesh.NumIndices);
+    if (FirstIndex == RangeAllocator::InvalidOffset)
+    {
+        m_VertexAllocator.Free(FirstVertex, Mesh.NumVertices);
+        LOG_ERROR_MESSAGE("Geometry pool is out of index space");
+        return {};
+    }
+
+    MeshHandle Handle;
+    Handle.FirstVertex        = FirstVertex;
+    Handle.NumVertices        = Mesh.NumVertices;
+    Handle.FirstIndexLocation = FirstIndex;
+    Handle.NumIndices         = Mesh.NumIndices;
+    // With or without base vertex support, the vertex id of the first vertex is FirstVertex,
+    // so the view element of vertex V is simply V * stride.
+    Handle.VertexBase   = 0;
+    Handle.VertexFormat = PackVertexFormat(VertexStrideInFloats, offsetof(MeshVertex, pos) / sizeof(float), offsetof(MeshVertex, uv) / sizeof(float));
+
+    pContext->UpdateBuffer(m_pVertexBuffer, Uint64{FirstVertex} * sizeof(MeshVertex), Uint64{Mesh.NumVertices} * sizeof(MeshVertex),
+                           Mesh.pVertices, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    if (m_pPositionBuffer)
+    {
+        std::vector<float3> Positions(Mesh.NumVertices);
+        for (Uint32 v = 0; v < Mesh.NumVertices; ++v)
+            Positions[v] = Mesh.pVertices[v].pos;
+        pContext->UpdateBuffer(m_pPositionBuffer, Uint64{FirstVertex} * sizeof(float3), Uint64{Mesh.NumVertices} * sizeof(float3),
+                               Positions.data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+
+    if (m_BaseVertexSupported)
+    {
+        Handle.BaseVertex = FirstVertex;
+        pContext->UpdateBuffer(m_pIndexBuffer, Uint64{FirstIndex} * sizeof(Uint32), Uint64{Mesh.NumIndices} * sizeof(Uint32),
+                               Mesh.pIndices, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+    else
+    {
+        std::vector<Uint32> Indices(Mesh.pIndices, Mesh.pIndices + Mesh.NumIndices);
+        for (Uint32& Idx : Indices)
+            Idx += FirstVertex;
+        pContext->UpdateBuffer(m_pIndexBuffer, Uint64{FirstIndex} * sizeof(Uint32), Uint64{Mesh.NumIndices} * sizeof(Uint32),
+                               Indices.data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+
+    return Handle;
+}
+
+void GeometryPool::Release(const MeshHandle& Handle)
+{
+    if (!Handle.IsValid())
+        return;
+
+    m_VertexAllocator.Free(Handle.FirstVertex, Handle.NumVertices);
+    m_IndexAllocator.Free(Handle.FirstIndexLocation, Handle.NumIndices);
+}
+
+} // namespace Diligent
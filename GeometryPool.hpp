@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "MeshData.hpp"
+
+namespace Diligent
+{
+
+// Suballocates vertices and indices of all meshes from one large vertex buffer and one
+// large index buffer, so that any mix of meshes can be drawn without rebinding buffers.
+// A mesh is identified by a handle that records where its data lives in the pool.
+class GeometryPool
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice* pDevice     = nullptr;
+        Uint32         MaxVertices = 1u << 18u;
+        Uint32         MaxIndices  = 1u << 20u;
+
+        // If the device does not support base vertex, indices are rebased on upload
+        // and every handle reports BaseVertex = 0.
+        bool BaseVertexSupported = true;
+
+        // If true, shaders can also read the vertex buffer through a float buffer view,
+        // for vertex pulling. Where the vertices of a mesh are and how they are laid out
+        // is described by the VertexBase and VertexFormat of its handle.
+        bool ShaderResourceVertices = false;
+
+        // If true, positions are also stored in a separate tightly packed buffer, so
+        // that depth-only passes fetch 12 bytes per vertex instead of the full vertex.
+        bool PositionStream = false;
+    };
+
+    static constexpr Uint32 VertexStrideInFloats = sizeof(MeshVertex) / sizeof(float);
+
+    // Vertex layout read by pulling vertex shaders, see UnpackVertexFormat() in gpu_scene.fxh.
+    // Stride and offsets are in floats.
+    static constexpr Uint32 PackVertexFormat(Uint32 StrideInFloats, Uint32 PositionOffset, Uint32 UVOffset)
+    {
+        return StrideInFloats | (PositionOffset << 8u) | (UVOffset << 16u);
+    }
+
+    struct MeshHandle
+    {
+        Uint32 BaseVertex         = 0;
+        Uint32 FirstIndexLocation = 0;
+        Uint32 NumIndices         = 0;
+
+        // Pulled vertex V, numbered as in the vertex shader with the base vertex included,
+        // starts at float VertexBase + V * stride in the vertex buffer view. All meshes
+        // currently use the MeshVertex layout, so the base is always zero.
+        Uint32 VertexBase   = 0;
+        Uint32 VertexFormat = 0;
+
+        // Location of the vertices in the pool, needed to release them
+        Uint32 FirstVertex = 0;
+        Uint32 NumVertices = 0;
+
+        bool IsValid() const { return NumIndices != 0; }
+    };
+
+    explicit GeometryPool(const CreateInfo& CI);
+
+    // Allocates space for the mesh and uploads its data using the context.
+    // Returns an invalid handle if the pool is full.
+    MeshHandle Allocate(IDeviceContext* pContext, const MeshData& Mesh);
+
+    void Release(const MeshHandle& Handle);
+
+    IBuffer* GetVertexBuffer() const { return m_pVertexBuffer; }
+    IBuffer* GetIndexBuffer() const { return m_pIndexBuffer; }
+
+    // Null unless the pool was created with PositionStream. Vertex N of the
+    // vertex buffer and position N of this buffer are the same vertex.
+    IBuffer* GetPositionBuffer() const { return m_pPositionBuffer; }
+
+    // Null unless the pool was created with ShaderResourceVertices
+    IBufferView* GetVertexBufferSRV() const { return m_pVertexBufferSRV; }
+
+    // Float view of the position buffer, three floats per vertex. Null unless the
+    // pool was created with both ShaderResourceVertices and PositionStream.
+    IBufferView* GetPositionBufferSRV() const { return m_pPositionBufferSRV; }
+
+private:
+    // First-fit allocator of contiguous element ranges. Freed ranges are merged with
+    // their neighbors to limit fragmentation.
+    class RangeAllocator
+    {
+    public:
+        static constexpr Uint32 InvalidOffset = ~0u;
+
+        explicit RangeAllocator(Uint32 Size);
+
+        Uint32 Allocate(Uint32 Size);
+        void   Free(Uint32 Offset, Uint32 Size);
+
+    private:
+        struct Range
+        {
+            Uint32 Offset;
+            Uint32 Size;
+        };
+        // Sorted by offset
+        std::vector<Range> m_FreeRanges;
+    };
+
+    const bool m_BaseVertexSupported;
+
+    RefCntAutoPtr<IBuffer>     m_pVertexBuffer;
+    RefCntAutoPtr<IBufferView> m_pVertexBufferSRV;
+    RefCntAutoPtr<IBuffer>     m_pPositionBuffer;
+    RefCntAutoPtr<IBufferView> m_pPositionBufferSRV;
+    RefCntAutoPtr<IBuffer>     m_pIndexBuffer;
+
+    RangeAllocator m_VertexAllocator;
+    RangeAllocator m_IndexAllocator;
+};
+
+} // namespace Diligent
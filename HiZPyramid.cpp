@@ -0,0 +1,158 @@
+#include "HiZPyramid.hpp"
+
+#include <algorithm>
+
+#include "ShaderMacroHelper.hpp"
+
+namespace Diligent
+{
+
+HiZPyramid::HiZPyramid(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice},
+    m_DepthFormat{CI.DepthFormat}
+{
+    ComputePipelineStateCreateInfo PSOCreateInfo;
+    PSOCreateInfo.PSODesc.Name         = "Hi-Z downsample PSO";
+    PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_COMPUTE;
+    PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage             = SHADER_SOURCE_LANGUAGE_HLSL;
+    ShaderCI.pShaderSourceStreamFactory = CI.pShaderSourceFactory;
+
+    ShaderMacroHelper Macros;
+    Macros.AddShaderMacro("THREAD_GROUP_SIZE", ThreadGroupSize);
+    ShaderCI.Macros = Macros;
+
+    RefCntAutoPtr<IShader> pCS;
+    {
+        ShaderCI.Desc.ShaderType = SHADER_TYPE_COMPUTE;
+        ShaderCI.EntryPoint      = "main";
+        ShaderCI.Desc.Name       = "Hi-Z downsample CS";
+        ShaderCI.FilePath        = "hiz_downsample.csh";
+        m_pDevice->CreateShader(ShaderCI, &pCS);
+    }
+    PSOCreateInfo.pCS = pCS;
+
+    // Source and destination change with every level
+    PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE;
+
+    m_pDevice->CreateComputePipelineState(PSOCreateInfo, &m_pDownsamplePSO);
+}
+
+void HiZPyramid::Resize(Uint32 Width, Uint32 Height)
+{
+    if (m_pDepth && m_pDepth->GetDesc().Width == Width && m_pDepth->GetDesc().Height == Height)
+        return;
+
+    m_LevelSRBs.clear();
+
+    TextureDesc TexDesc;
+    TexDesc.Name      = "Hi-Z depth buffer";
+    TexDesc.Type      = RESOURCE_DIM_TEX_2D;
+    TexDesc.Width     = Width;
+    TexDesc.Height    = Height;
+    TexDesc.Format    = m_DepthFormat;
+    TexDesc.BindFlags = BIND_DEPTH_STENCIL | BIND_SHADER_RESOURCE;
+    m_pDepth.Release();
+    m_pDevice->CreateTexture(TexDesc, nullptr, &m_pDepth);
+    m_pDepthDSV = m_pDepth->GetDefaultView(TEXTURE_VIEW_DEPTH_STENCIL);
+
+    TexDesc.Name      = "Hi-Z pyramid";
+    TexDesc.Width     = std::max((Width + 1) / 2, 1u);
+    TexDesc.Height    = std::max((Height + 1) / 2, 1u);
+    TexDesc.Format    = TEX_FORMAT_R32_FLOAT;
+    TexDesc.BindFlags = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+    TexDesc.MipLevels = 1;
+    for (Uint32 Size = std::max(TexDesc.Width, TexDesc.Height); Size > 1; Size /= 2)
+        ++TexDesc.MipLevels;
+    m_pPyramid.Release();
+    m_pDevice->CreateTexture(TexDesc, nullptr, &m_pPyramid);
+    m_pPyramidSRV = m_pPyramid->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+
+    for (Uint32 Level = 0; Level < TexDesc.MipLevels; ++Level)
+    {
+        RefCntAutoPtr<ITextureView> pSrcSRV;
+        if (Level == 0)
+        {
+            pSrcSRV = m_pDepth->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+        }
+        else
+        {
+            TextureViewDesc ViewDesc;
+            ViewDesc.Name            = "Hi-Z pyramid level SRV";
+            ViewDesc.ViewType        = TEXTURE_VIEW_SHADER_RESOURCE;
+            ViewDesc.TextureDim      = RESOURCE_DIM_TEX_2D;
+            ViewDesc.MostDetailedMip = Level - 1;
+            ViewDesc.NumMipLevels    = 1;
+            m_pPyramid->CreateView(ViewDesc, &pSrcSRV);
+        }
+
+        RefCntAutoPtr<ITextureView> pDstUAV;
+        {
+            TextureViewDesc ViewDesc;
+            ViewDesc.Name            = "Hi-Z pyramid level UAV";
+            ViewDesc.ViewType        = TEXTURE_VIEW_UNORDERED_ACCESS;
+            ViewDesc.TextureDim      = RESOURCE_DIM_TEX_2D;
+            ViewDesc.MostDetailedMip = Level;
+            ViewDesc.NumMipLevels    = 1;
+            m_pPyramid->CreateView(ViewDesc, &pDstUAV);
+        }
+
+        RefCntAutoPtr<IShaderResourceBinding> pSRB;
+        m_pDownsamplePSO->CreateShaderResourceBinding(&pSRB, true);
+        pSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "g_SrcDepth")->Set(pSrcSRV);
+        pSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "g_DstDepth")->Set(pDstUAV);
+        m_LevelSRBs.emplace_back(std::move(pSRB));
+    }
+}
+
+void HiZPyramid::Build(IDeviceContext* pContext)
+{
+    const TextureDesc& PyramidDesc = m_pPyramid->GetDesc();
+
+    // Every level is read by the dispatch that builds the next one, so levels are
+    // transitioned one by one and the engine does not track them in between.
+    StateTransitionDesc Barriers[2];
+    Barriers[0].pResource = m_pDepth;
+    Barriers[0].OldState  = RESOURCE_STATE_UNKNOWN;
+    Barriers[0].NewState  = RESOURCE_STATE_SHADER_RESOURCE;
+    Barriers[0].Flags     = STATE_TRANSITION_FLAG_UPDATE_STATE;
+    Barriers[1].pResource = m_pPyramid;
+    Barriers[1].OldState  = RESOURCE_STATE_UNKNOWN;
+    Barriers[1].NewState  = RESOURCE_STATE_UNORDERED_ACCESS;
+    Barriers[1].Flags     = STATE_TRANSITION_FLAG_UPDATE_STATE;
+    pContext->TransitionResourceStates(_countof(Barriers), Barriers);
+
+    auto TransitionLevelToShaderResource = [&](Uint32 Level) {
+        StateTransitionDesc Barrier;
+        Barrier.pResource      = m_pPyramid;
+        Barrier.FirstMipLevel  = Level;
+        Barrier.MipLevelsCount = 1;
+        Barrier.OldState       = RESOURCE_STATE_UNORDERED_ACCESS;
+        Barrier.NewState       = RESOURCE_STATE_SHADER_RESOURCE;
+        pContext->TransitionResourceStates(1, &Barrier);
+    };
+
+    pContext->SetPipelineState(m_pDownsamplePSO);
+    for (Uint32 Level = 0; Level < PyramidDesc.MipLevels; ++Level)
+    {
+        if (Level > 0)
+            TransitionLevelToShaderResource(Level - 1);
+
+        pContext->CommitShaderResources(m_LevelSRBs[Level], RESOURCE_STATE_TRANSITION_MODE_NONE);
+
+        const Uint32 LevelWidth  = std::max(PyramidDesc.Width >> Level, 1u);
+        const Uint32 LevelHeight = std::max(PyramidDesc.Height >> Level, 1u);
+        pContext->DispatchCompute(DispatchComputeAttribs{
+            (LevelWidth + ThreadGroupSize - 1) / ThreadGroupSize,
+            (LevelHeight + ThreadGroupSize - 1) / ThreadGroupSize,
+        });
+    }
+    TransitionLevelToShaderResource(PyramidDesc.MipLevels - 1);
+
+    // All levels are now readable
+    m_pPyramid->SetState(RESOURCE_STATE_SHADER_RESOURCE);
+}
+
+} // namespace Diligent
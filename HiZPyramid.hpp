@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+
+namespace Diligent
+{
+
+// Hierarchical depth (Hi-Z) pyramid for occlusion culling.
+//
+// Owns a depth buffer that can be read by shaders. The first level of the pyramid is half
+// the size of the depth buffer, and every texel of a level stores the farthest depth of
+// the area it covers, so an object whose nearest depth is farther than the texels under
+// its screen bounds is hidden. Levels are built by a compute shader, one dispatch per level.
+class HiZPyramid
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice*                   pDevice              = nullptr;
+        IShaderSourceInputStreamFactory* pShaderSourceFactory = nullptr;
+
+        // Format of the depth buffer. Must be compatible with the pipelines that render into it.
+        TEXTURE_FORMAT DepthFormat = TEX_FORMAT_D32_FLOAT;
+
+        // Optional cache the pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+    };
+
+    explicit HiZPyramid(const CreateInfo& CI);
+
+    // Recreates the depth buffer and the pyramid if the size changed
+    void Resize(Uint32 Width, Uint32 Height);
+
+    // Builds the pyramid from the current contents of the depth buffer.
+    // The depth buffer must not be bound as a render target.
+    void Build(IDeviceContext* pContext);
+
+    ITextureView* GetDepthDSV() const { return m_pDepthDSV; }
+    ITextureView* GetPyramidSRV() const { return m_pPyramidSRV; }
+
+private:
+    static constexpr Uint32 ThreadGroupSize = 8;
+
+    RefCntAutoPtr<IRenderDevice> m_pDevice;
+    const TEXTURE_FORMAT         m_DepthFormat;
+
+    RefCntAutoPtr<IPipelineState> m_pDownsamplePSO;
+
+    RefCntAutoPtr<ITexture>     m_pDepth;
+    RefCntAutoPtr<ITextureView> m_pDepthDSV;
+    RefCntAutoPtr<ITexture>     m_pPyramid;
+    RefCntAutoPtr<ITextureView> m_pPyramidSRV;
+
+    // One per level of the pyramid. Each binding keeps its source and destination views alive.
+    std::vector<RefCntAutoPtr<IShaderResourceBinding>> m_LevelSRBs;
+};
+
+} // namespace Diligent
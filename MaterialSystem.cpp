@@ -0,0 +1,97 @@
+#include "MaterialSystem.hpp"
+
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+size_t MaterialSystem::MaterialStateHash::operator()(const MaterialState& State) const
+{
+    std::hash<std::string> StrHash;
+
+    size_t Hash = StrHash(State.PSFilePath);
+    for (const auto& Macro : State.Macros)
+    {
+        Hash = Hash * 31u + StrHash(Macro.first);
+        Hash = Hash * 31u + StrHash(Macro.second);
+    }
+    Hash = Hash * 31u + static_cast<size_t>(State.CullMode);
+    return Hash;
+}
+
+MaterialSystem::MaterialSystem(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice}
+{
+    // clang-format off
+    // Mutable resources are set in the SRB after it is created
+    PipelineResourceDesc Resources[] =
+    {
+        {SHADER_TYPE_PIXEL, "g_Texture", 1, SHADER_RESOURCE_TYPE_TEXTURE_SRV, SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE}
+    };
+    // Define immutable sampler for g_Texture. Immutable samplers should be used whenever possible
+    SamplerDesc SamLinearClampDesc
+    {
+        FILTER_TYPE_LINEAR, FILTER_TYPE_LINEAR, FILTER_TYPE_LINEAR,
+        TEXTURE_ADDRESS_CLAMP, TEXTURE_ADDRESS_CLAMP, TEXTURE_ADDRESS_CLAMP
+    };
+    ImmutableSamplerDesc ImtblSamplers[] =
+    {
+        {SHADER_TYPE_PIXEL, "g_Texture", SamLinearClampDesc}
+    };
+    // clang-format on
+
+    PipelineResourceSignatureDesc SignatureDesc;
+    SignatureDesc.Name                       = "Material signature";
+    SignatureDesc.Resources                  = Resources;
+    SignatureDesc.NumResources               = _countof(Resources);
+    SignatureDesc.ImmutableSamplers          = ImtblSamplers;
+    SignatureDesc.NumImmutableSamplers       = _countof(ImtblSamplers);
+    SignatureDesc.BindingIndex               = CI.SignatureBindingIndex;
+    SignatureDesc.UseCombinedTextureSamplers = true;
+    m_pDevice->CreatePipelineResourceSignature(SignatureDesc, &m_pSignature);
+}
+
+MaterialSystem::MaterialId MaterialSystem::AddMaterial(const MaterialDesc& Desc)
+{
+    Material Mat;
+
+    auto StateIt = m_StateIds.find(Desc.State);
+    if (StateIt == m_StateIds.end())
+    {
+        StateIt = m_StateIds.emplace(Desc.State, static_cast<Uint32>(m_States.size())).first;
+        m_States.push_back(Desc.State);
+    }
+    Mat.StateId = StateIt->second;
+
+    RefCntAutoPtr<IShaderResourceBinding>& pSRB = m_SRBs[Desc.pTexture];
+    if (!pSRB)
+    {
+        m_pSignature->CreateShaderResourceBinding(&pSRB, true);
+        pSRB->GetVariableByName(SHADER_TYPE_PIXEL, "g_Texture")->Set(Desc.pTexture);
+    }
+    Mat.pSRB = pSRB;
+
+    m_Materials.push_back(Mat);
+    return static_cast<MaterialId>(m_Materials.size() - 1);
+}
+
+IPipelineState* MaterialSystem::PreparePipeline(MaterialId Material, Uint32 Variant, const CreatePipelineCallback& Create)
+{
+    const Uint32 StateId = m_Materials[Material].StateId;
+
+    RefCntAutoPtr<IPipelineState>& pPSO = m_Pipelines[PipelineKey{StateId, Variant}];
+    if (!pPSO)
+    {
+        Create(m_States[StateId], &pPSO);
+        VERIFY(pPSO, "Failed to create the pipeline of the material");
+    }
+    return pPSO;
+}
+
+IPipelineState* MaterialSystem::GetPipeline(MaterialId Material, Uint32 Variant) const
+{
+    auto it = m_Pipelines.find(PipelineKey{m_Materials[Material].StateId, Variant});
+    return it != m_Pipelines.end() ? it->second.RawPtr() : nullptr;
+}
+
+} // namespace Diligent
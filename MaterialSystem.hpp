@@ -0,0 +1,121 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "RefCntAutoPtr.hpp"
+
+namespace Diligent
+{
+
+// Keeps the materials of the scene and the GPU objects they need.
+//
+// A material is plain data: the pixel shader with its macros, the render state and the
+// texture. Materials are split into the state, which determines the pipeline, and the
+// resources, which determine the shader resource binding. Both are deduplicated: materials
+// with equal states share pipelines, and materials with equal textures share one SRB. All
+// SRBs are created from the material signature, so any of them can be committed with any
+// pipeline created by the system.
+//
+// Pipelines and SRBs are only created when materials are added or pipelines are prepared,
+// which is expected to happen at load time. Lookups during rendering never create objects.
+class MaterialSystem
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice* pDevice = nullptr;
+
+        // Binding index of the material signature in the pipelines
+        Uint8 SignatureBindingIndex = 0;
+    };
+
+    // Everything that goes into the pipeline of a material
+    struct MaterialState
+    {
+        std::string                                      PSFilePath = "cube.psh";
+        std::vector<std::pair<std::string, std::string>> Macros;
+        CULL_MODE                                        CullMode = CULL_MODE_BACK;
+
+        bool operator==(const MaterialState& rhs) const
+        {
+            return PSFilePath == rhs.PSFilePath && Macros == rhs.Macros && CullMode == rhs.CullMode;
+        }
+    };
+
+    struct MaterialDesc
+    {
+        MaterialState State;
+        // Bound to g_Texture and sampled with a linear clamp sampler
+        ITextureView* pTexture = nullptr;
+    };
+
+    using MaterialId = Uint32;
+
+    // Creates the pipeline of the variant being prepared for the material state
+    using CreatePipelineCallback = std::function<void(const MaterialState& State, IPipelineState** ppPSO)>;
+
+    explicit MaterialSystem(const CreateInfo& CI);
+
+    // Adds the material and creates its SRB, unless a material with the same texture exists
+    MaterialId AddMaterial(const MaterialDesc& Desc);
+
+    // Returns the pipeline of the material for the variant, created with the callback if no
+    // material with the same state has it yet. Variants distinguish pipelines that differ in
+    // anything the material does not describe, e.g. the vertex shader or the depth test.
+    IPipelineState* PreparePipeline(MaterialId Material, Uint32 Variant, const CreatePipelineCallback& Create);
+
+    // Returns the pipeline prepared for the material and the variant, or null
+    IPipelineState* GetPipeline(MaterialId Material, Uint32 Variant) const;
+
+    IShaderResourceBinding*     GetSRB(MaterialId Material) const { return m_Materials[Material].pSRB; }
+    IPipelineResourceSignature* GetSignature() const { return m_pSignature; }
+
+    Uint32 GetNumMaterials() const { return static_cast<Uint32>(m_Materials.size()); }
+    Uint32 GetNumPipelines() const { return static_cast<Uint32>(m_Pipelines.size()); }
+    Uint32 GetNumSRBs() const { return static_cast<Uint32>(m_SRBs.size()); }
+
+private:
+    struct MaterialStateHash
+    {
+        size_t operator()(const MaterialState& State) const;
+    };
+
+    struct PipelineKey
+    {
+        Uint32 StateId;
+        Uint32 Variant;
+
+        bool operator==(const PipelineKey& rhs) const { return StateId == rhs.StateId && Variant == rhs.Variant; }
+    };
+
+    struct PipelineKeyHash
+    {
+        size_t operator()(const PipelineKey& Key) const { return size_t{Key.StateId} * 31u + Key.Variant; }
+    };
+
+    struct Material
+    {
+        // Index of the unique state of the material
+        Uint32                  StateId = 0;
+        IShaderResourceBinding* pSRB    = nullptr;
+    };
+
+    IRenderDevice*                            m_pDevice = nullptr;
+    RefCntAutoPtr<IPipelineResourceSignature> m_pSignature;
+
+    std::vector<Material> m_Materials;
+
+    std::vector<MaterialState>                                                       m_States;
+    std::unordered_map<MaterialState, Uint32, MaterialStateHash>                     m_StateIds;
+    std::unordered_map<PipelineKey, RefCntAutoPtr<IPipelineState>, PipelineKeyHash> m_Pipelines;
+
+    // Keyed by the texture. The SRB keeps the texture alive, so the key stays valid.
+    std::unordered_map<ITextureView*, RefCntAutoPtr<IShaderResourceBinding>> m_SRBs;
+};
+
+} // namespace Diligent
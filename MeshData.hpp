@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Layout of this structure matches the input layout of the cube pipeline states
+struct MeshVertex
+{
+    float3 pos;
+    float2 uv;
+};
+
+// Non-owning view of CPU-side mesh geometry
+struct MeshData
+{
+    const MeshVertex* pVertices   = nullptr;
+    Uint32            NumVertices = 0;
+    const Uint32*     pIndices    = nullptr;
+    Uint32            NumIndices  = 0;
+};
+
+// Sphere that encloses all vertices of a mesh, in the space of the mesh
+struct BoundingSphere
+{
+    float3 Center;
+    float  Radius = 0;
+};
+
+// Returns the sphere centered at the middle of the mesh bounding box
+inline BoundingSphere ComputeBoundingSphere(const MeshData& Mesh)
+{
+    BoundingSphere Sphere;
+    if (Mesh.NumVertices == 0)
+        return Sphere;
+
+    float3 Min = Mesh.pVertices[0].pos;
+    float3 Max = Mesh.pVertices[0].pos;
+    for (Uint32 v = 1; v < Mesh.NumVertices; ++v)
+    {
+        Min = min(Min, Mesh.pVertices[v].pos);
+        Max = max(Max, Mesh.pVertices[v].pos);
+    }
+
+    Sphere.Center = (Min + Max) * 0.5f;
+    for (Uint32 v = 0; v < Mesh.NumVertices; ++v)
+        Sphere.Radius = std::max(Sphere.Radius, length(Mesh.pVertices[v].pos - Sphere.Center));
+    return Sphere;
+}
+
+} // namespace Diligent
@@ -0,0 +1,449 @@
+#include "MeshImport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "FileWrapper.hpp"
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+namespace
+{
+
+// Cache size the triangle order is optimized for. Larger than the cache of most GPUs, which
+// works well for smaller caches too.
+constexpr Uint32 VertexCacheSize = 32;
+
+// Cache size used to find the cluster boundaries for overdraw optimization, and the
+// increase in ACMR that overdraw optimization is allowed to cause
+constexpr Uint32 OverdrawCacheSize       = 16;
+constexpr float  OverdrawMaxACMRIncrease = 1.05f;
+
+struct MeshVertexHash
+{
+    size_t operator()(const MeshVertex& Vert) const
+    {
+        Uint32 Words[sizeof(MeshVertex) / sizeof(Uint32)];
+        memcpy(Words, &Vert, sizeof(Words));
+
+        size_t Hash = 0;
+        for (Uint32 Word : Words)
+            Hash = Hash * 31u + Word;
+        return Hash;
+    }
+};
+
+struct MeshVertexEqual
+{
+    bool operator()(const MeshVertex& lhs, const MeshVertex& rhs) const
+    {
+        return memcmp(&lhs, &rhs, sizeof(MeshVertex)) == 0;
+    }
+};
+
+// Vertex score of Forsyth's algorithm. Vertices that were used recently and vertices
+// with few remaining triangles are preferred.
+float ComputeVertexScore(int CachePos, Uint32 NumRemainingTris)
+{
+    if (NumRemainingTris == 0)
+        return -1;
+
+    float Score = 0;
+    if (CachePos >= 0)
+    {
+        if (CachePos < 3)
+        {
+            // The vertices of the last triangle get a fixed score, so that the next
+            // triangle does not have to share an edge with it.
+            Score = 0.75f;
+        }
+        else
+        {
+            const float Scale = 1.f / static_cast<float>(VertexCacheSize - 3);
+            Score             = std::pow(1.f - static_cast<float>(CachePos - 3) * Scale, 1.5f);
+        }
+    }
+
+    // Finish vertices with few triangles left, so they do not need to be reloaded later
+    Score += 2.f / std::sqrt(static_cast<float>(NumRemainingTris));
+    return Score;
+}
+
+} // namespace
+
+bool LoadOBJ(const char* FilePath, MeshBuffers& Mesh)
+{
+    FileWrapper File{FilePath, EFileAccessMode::Read};
+    if (!File)
+    {
+        LOG_ERROR_MESSAGE("Failed to open mesh file '", FilePath, "'");
+        return false;
+    }
+
+    std::string Text(File->GetSize(), '\0');
+    if (!Text.empty() && !File->Read(&Text[0], Text.size()))
+    {
+        LOG_ERROR_MESSAGE("Failed to read mesh file '", FilePath, "'");
+        return false;
+    }
+
+    std::vector<float3> Positions;
+    std::vector<float2> TexCoords;
+
+    Mesh.Vertices.clear();
+    Mesh.Indices.clear();
+
+    // Every face corner becomes a new vertex. Duplicates are merged by WeldVertices().
+    auto AddCorner = [&](const std::string& Corner) {
+        // Corners are "v", "v/vt", "v//vn" or "v/vt/vn". Negative indices count from the end.
+        int PosIdx = 0, UVIdx = 0;
+        if (sscanf(Corner.c_str(), "%d/%d", &PosIdx, &UVIdx) < 1)
+            return false;
+        if (PosIdx < 0)
+            PosIdx += static_cast<int>(Positions.size()) + 1;
+        if (UVIdx < 0)
+            UVIdx += static_cast<int>(TexCoords.size()) + 1;
+        if (PosIdx < 1 || PosIdx > static_cast<int>(Positions.size()) || UVIdx > static_cast<int>(TexCoords.size()))
+            return false;
+
+        MeshVertex Vert;
+        Vert.pos = Positions[PosIdx - 1];
+        // OBJ texture coordinates start at the bottom of the image
+        Vert.uv = UVIdx > 0 ? float2{TexCoords[UVIdx - 1].x, 1.f - TexCoords[UVIdx - 1].y} : float2{0, 0};
+        Mesh.Vertices.push_back(Vert);
+        return true;
+    };
+
+    std::istringstream Stream{Text};
+    std::string        Line;
+    for (Uint32 LineNum = 1; std::getline(Stream, Line); ++LineNum)
+    {
+        std::istringstream LineStream{Line};
+        std::string        Keyword;
+        LineStream >> Keyword;
+        if (Keyword == "v")
+        {
+            float3 Pos;
+            LineStream >> Pos.x >> Pos.y >> Pos.z;
+            Pos.z = -Pos.z;
+            Positions.push_back(Pos);
+        }
+        else if (Keyword == "vt")
+        {
+            float2 UV;
+            LineStream >> UV.x >> UV.y;
+            TexCoords.push_back(UV);
+        }
+        else if (Keyword == "f")
+        {
+            const Uint32 FirstVertex = static_cast<Uint32>(Mesh.Vertices.size());
+
+            std::string Corner;
+            while (LineStream >> Corner)
+            {
+                if (!AddCorner(Corner))
+                {
+                    LOG_ERROR_MESSAGE("Invalid face in mesh file '", FilePath, "', line ", LineNum);
+                    return false;
+                }
+            }
+
+            const Uint32 NumCorners = static_cast<Uint32>(Mesh.Vertices.size()) - FirstVertex;
+            for (Uint32 i = 2; i < NumCorners; ++i)
+            {
+                Mesh.Indices.push_back(FirstVertex);
+                Mesh.Indices.push_back(FirstVertex + i - 1);
+                Mesh.Indices.push_back(FirstVertex + i);
+            }
+        }
+        // Normals, groups and materials are not used
+    }
+
+    if (Mesh.Indices.empty())
+    {
+        LOG_ERROR_MESSAGE("Mesh file '", FilePath, "' contains no triangles");
+        return false;
+    }
+    return true;
+}
+
+void WeldVertices(MeshBuffers& Mesh)
+{
+    std::unordered_map<MeshVertex, Uint32, MeshVertexHash, MeshVertexEqual> UniqueVertices;
+    UniqueVertices.reserve(Mesh.Vertices.size());
+
+    std::vector<MeshVertex> Vertices;
+    std::vector<Uint32>     Remap(Mesh.Vertices.size());
+    for (size_t v = 0; v < Mesh.Vertices.size(); ++v)
+    {
+        const auto It = UniqueVertices.emplace(Mesh.Vertices[v], static_cast<Uint32>(Vertices.size()));
+        if (It.second)
+            Vertices.push_back(Mesh.Vertices[v]);
+        Remap[v] = It.first->second;
+    }
+
+    for (Uint32& Idx : Mesh.Indices)
+        Idx = Remap[Idx];
+    Mesh.Vertices = std::move(Vertices);
+}
+
+void OptimizeVertexCache(MeshBuffers& Mesh)
+{
+    const Uint32 NumVertices = static_cast<Uint32>(Mesh.Vertices.size());
+    const Uint32 NumTris     = static_cast<Uint32>(Mesh.Indices.size() / 3);
+    if (NumTris == 0)
+        return;
+
+    // Triangles of every vertex. The first NumRemainingTris[v] entries of the
+    // vertex's range are the triangles that are not emitted yet.
+    std::vector<Uint32> NumRemainingTris(NumVertices);
+    for (Uint32 Idx : Mesh.Indices)
+        ++NumRemainingTris[Idx];
+
+    std::vector<Uint32> VertexTrisOffset(NumVertices + 1);
+    for (Uint32 v = 0; v < NumVertices; ++v)
+        VertexTrisOffset[v + 1] = VertexTrisOffset[v] + NumRemainingTris[v];
+
+    std::vector<Uint32> VertexTris(VertexTrisOffset[NumVertices]);
+    {
+        std::vector<Uint32> Fill(VertexTrisOffset.begin(), VertexTrisOffset.end() - 1);
+        for (Uint32 t = 0; t < NumTris; ++t)
+        {
+            for (Uint32 c = 0; c < 3; ++c)
+                VertexTris[Fill[Mesh.Indices[t * 3 + c]]++] = t;
+        }
+    }
+
+    std::vector<int>   CachePos(NumVertices, -1);
+    std::vector<float> VertexScore(NumVertices);
+    for (Uint32 v = 0; v < NumVertices; ++v)
+        VertexScore[v] = ComputeVertexScore(-1, NumRemainingTris[v]);
+
+    std::vector<float> TriScore(NumTris);
+    std::vector<bool>  TriEmitted(NumTris);
+    for (Uint32 t = 0; t < NumTris; ++t)
+    {
+        for (Uint32 c = 0; c < 3; ++c)
+            TriScore[t] += VertexScore[Mesh.Indices[t * 3 + c]];
+    }
+
+    std::vector<Uint32> Cache;
+    std::vector<Uint32> NewCache;
+    Cache.reserve(VertexCacheSize + 3);
+    NewCache.reserve(VertexCacheSize + 3);
+
+    std::vector<Uint32> Indices;
+    Indices.reserve(Mesh.Indices.size());
+
+    Uint32 BestTri      = 0;
+    Uint32 SearchCursor = 0;
+    for (Uint32 i = 0; i < NumTris; ++i)
+    {
+        // No triangle in the cache has remaining work, so start from the next unused one
+        if (BestTri == ~0u)
+        {
+            while (TriEmitted[SearchCursor])
+                ++SearchCursor;
+            BestTri = SearchCursor;
+        }
+
+        const Uint32* TriVerts = &Mesh.Indices[BestTri * 3];
+        Indices.insert(Indices.end(), TriVerts, TriVerts + 3);
+        TriEmitted[BestTri] = true;
+
+        // Remove the triangle from the remaining triangles of its vertices
+        for (Uint32 c = 0; c < 3; ++c)
+        {
+            const Uint32 v     = TriVerts[c];
+            Uint32*      pTris = &VertexTris[VertexTrisOffset[v]];
+            Uint32*      pEnd  = pTris + NumRemainingTris[v];
+            std::swap(*std::find(pTris, pEnd, BestTri), pEnd[-1]);
+            --NumRemainingTris[v];
+        }
+
+        // The triangle's vertices move to the front of the cache
+        NewCache.assign(TriVerts, TriVerts + 3);
+        for (Uint32 v : Cache)
+        {
+            if (v != TriVerts[0] && v != TriVerts[1] && v != TriVerts[2])
+                NewCache.push_back(v);
+        }
+        std::swap(Cache, NewCache);
+
+        for (Uint32 p = 0; p < Cache.size(); ++p)
+        {
+            const Uint32 v = Cache[p];
+            CachePos[v]    = p < VertexCacheSize ? static_cast<int>(p) : -1;
+            VertexScore[v] = ComputeVertexScore(CachePos[v], NumRemainingTris[v]);
+        }
+
+        // Only triangles of the vertices whose scores changed need to be rescored
+        BestTri            = ~0u;
+        float BestTriScore = -1;
+        for (Uint32 v : Cache)
+        {
+            for (Uint32 j = 0; j < NumRemainingTris[v]; ++j)
+            {
+                const Uint32 t = VertexTris[VertexTrisOffset[v] + j];
+
+                TriScore[t] = 0;
+                for (Uint32 c = 0; c < 3; ++c)
+                    TriScore[t] += VertexScore[Mesh.Indices[t * 3 + c]];
+
+                if (TriScore[t] > BestTriScore)
+                {
+                    BestTriScore = TriScore[t];
+                    BestTri      = t;
+                }
+            }
+        }
+
+        if (Cache.size() > VertexCacheSize)
+            Cache.resize(VertexCacheSize);
+    }
+
+    Mesh.Indices = std::move(Indices);
+}
+
+void OptimizeOverdraw(MeshBuffers& Mesh)
+{
+    const Uint32 NumTris = static_cast<Uint32>(Mesh.Indices.size() / 3);
+    if (NumTris < 2)
+        return;
+
+    // A cluster starts at every triangle whose vertices all miss the cache
+    std::vector<Uint32> ClusterStarts;
+    {
+        std::vector<Uint32> InsertTime(Mesh.Vertices.size());
+        Uint32              Time = OverdrawCacheSize + 1;
+        for (Uint32 t = 0; t < NumTris; ++t)
+        {
+            Uint32 Misses = 0;
+            for (Uint32 c = 0; c < 3; ++c)
+            {
+                const Uint32 v = Mesh.Indices[t * 3 + c];
+                if (Time - InsertTime[v] > OverdrawCacheSize)
+                {
+                    InsertTime[v] = Time++;
+                    ++Misses;
+                }
+            }
+            if (t == 0 || Misses == 3)
+                ClusterStarts.push_back(t);
+        }
+    }
+    const Uint32 NumClusters = static_cast<Uint32>(ClusterStarts.size());
+    if (NumClusters < 2)
+        return;
+    ClusterStarts.push_back(NumTris);
+
+    // Area-weighted centroids and normals of the clusters and of the whole mesh
+    std::vector<float3> ClusterCentroids(NumClusters);
+    std::vector<float3> ClusterNormals(NumClusters);
+    float3              MeshCentroid;
+    float               MeshArea = 0;
+    for (Uint32 c = 0; c < NumClusters; ++c)
+    {
+        float ClusterArea = 0;
+        for (Uint32 t = ClusterStarts[c]; t < ClusterStarts[c + 1]; ++t)
+        {
+            const float3& P0 = Mesh.Vertices[Mesh.Indices[t * 3 + 0]].pos;
+            const float3& P1 = Mesh.Vertices[Mesh.Indices[t * 3 + 1]].pos;
+            const float3& P2 = Mesh.Vertices[Mesh.Indices[t * 3 + 2]].pos;
+
+            const float3 Normal = cross(P1 - P0, P2 - P0);
+            const float  Area   = length(Normal);
+
+            ClusterCentroids[c] += (P0 + P1 + P2) * (Area / 3.f);
+            ClusterNormals[c] += Normal;
+            ClusterArea += Area;
+        }
+
+        MeshCentroid += ClusterCentroids[c];
+        MeshArea += ClusterArea;
+        if (ClusterArea > 0)
+            ClusterCentroids[c] = ClusterCentroids[c] / ClusterArea;
+    }
+    if (MeshArea > 0)
+        MeshCentroid = MeshCentroid / MeshArea;
+
+    // Clusters that face away from the center occlude the others from most directions
+    std::vector<float> ClusterSortKeys(NumClusters);
+    for (Uint32 c = 0; c < NumClusters; ++c)
+    {
+        const float NormalLength = length(ClusterNormals[c]);
+        ClusterSortKeys[c]       = NormalLength > 0 ? dot(ClusterCentroids[c] - MeshCentroid, ClusterNormals[c]) / NormalLength : 0;
+    }
+
+    std::vector<Uint32> ClusterOrder(NumClusters);
+    for (Uint32 c = 0; c < NumClusters; ++c)
+        ClusterOrder[c] = c;
+    std::stable_sort(ClusterOrder.begin(), ClusterOrder.end(), [&](Uint32 lhs, Uint32 rhs) {
+        return ClusterSortKeys[lhs] > ClusterSortKeys[rhs];
+    });
+
+    MeshBuffers Reordered;
+    Reordered.Vertices = Mesh.Vertices;
+    Reordered.Indices.reserve(Mesh.Indices.size());
+    for (Uint32 c : ClusterOrder)
+        Reordered.Indices.insert(Reordered.Indices.end(), Mesh.Indices.begin() + ClusterStarts[c] * 3, Mesh.Indices.begin() + ClusterStarts[c + 1] * 3);
+
+    if (ComputeACMR(Reordered, VertexCacheSize) <= ComputeACMR(Mesh, VertexCacheSize) * OverdrawMaxACMRIncrease)
+        Mesh.Indices = std::move(Reordered.Indices);
+}
+
+void OptimizeVertexFetch(MeshBuffers& Mesh)
+{
+    std::vector<Uint32>     Remap(Mesh.Vertices.size(), ~0u);
+    std::vector<MeshVertex> Vertices;
+    Vertices.reserve(Mesh.Vertices.size());
+    for (Uint32& Idx : Mesh.Indices)
+    {
+        if (Remap[Idx] == ~0u)
+        {
+            Remap[Idx] = static_cast<Uint32>(Vertices.size());
+            Vertices.push_back(Mesh.Vertices[Idx]);
+        }
+        Idx = Remap[Idx];
+    }
+
+    // Vertices that no triangle uses are dropped
+    Mesh.Vertices = std::move(Vertices);
+}
+
+void OptimizeMesh(MeshBuffers& Mesh)
+{
+    WeldVertices(Mesh);
+    OptimizeVertexCache(Mesh);
+    OptimizeOverdraw(Mesh);
+    OptimizeVertexFetch(Mesh);
+}
+
+float ComputeACMR(const MeshBuffers& Mesh, Uint32 CacheSize)
+{
+    const size_t NumTris = Mesh.Indices.size() / 3;
+    if (NumTris == 0)
+        return 0;
+
+    std::vector<Uint32> InsertTime(Mesh.Vertices.size());
+    Uint32              Time   = CacheSize + 1;
+    Uint32              Misses = 0;
+    for (Uint32 Idx : Mesh.Indices)
+    {
+        if (Time - InsertTime[Idx] > CacheSize)
+        {
+            InsertTime[Idx] = Time++;
+            ++Misses;
+        }
+    }
+    return static_cast<float>(Misses) / static_cast<float>(NumTris);
+}
+
+} // namespace Diligent
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "MeshData.hpp"
+
+namespace Diligent
+{
+
+// CPU-side mesh that owns its geometry
+struct MeshBuffers
+{
+    std::vector<MeshVertex> Vertices;
+    std::vector<Uint32>     Indices;
+
+    MeshBuffers() = default;
+
+    explicit MeshBuffers(const MeshData& Mesh) :
+        Vertices{Mesh.pVertices, Mesh.pVertices + Mesh.NumVertices},
+        Indices{Mesh.pIndices, Mesh.pIndices + Mesh.NumIndices}
+    {}
+
+    // The view is invalidated when the vectors are modified
+    MeshData GetData() const
+    {
+        return MeshData{Vertices.data(), static_cast<Uint32>(Vertices.size()), Indices.data(), static_cast<Uint32>(Indices.size())};
+    }
+};
+
+// Loads positions, texture coordinates and faces of a Wavefront OBJ file. Polygons are
+// triangulated as fans. The Z axis is flipped to convert the right-handed OBJ space to the
+// left-handed space of the scene, which also turns counter-clockwise OBJ faces clockwise.
+// Returns false if the file cannot be read or contains no triangles.
+bool LoadOBJ(const char* FilePath, MeshBuffers& Mesh);
+
+// Merges vertices with identical attributes
+void WeldVertices(MeshBuffers& Mesh);
+
+// Reorders triangles so that their vertices are likely to be in the post-transform
+// vertex cache (Tom Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(MeshBuffers& Mesh);
+
+// Reorders clusters of triangles so that outward-facing clusters are drawn first, which
+// reduces overdraw from any direction. Clusters start where the triangle order already
+// misses the vertex cache, so the result of OptimizeVertexCache() is mostly preserved.
+void OptimizeOverdraw(MeshBuffers& Mesh);
+
+// Reorders vertices in the order of their first use, so that vertex fetches are sequential
+void OptimizeVertexFetch(MeshBuffers& Mesh);
+
+// Runs all of the above in order. Must be called before the buffers of the mesh are created.
+void OptimizeMesh(MeshBuffers& Mesh);
+
+// Average number of vertex shader invocations per triangle for a FIFO cache of the given size
+float ComputeACMR(const MeshBuffers& Mesh, Uint32 CacheSize);
+
+} // namespace Diligent
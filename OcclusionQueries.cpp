@@ -0,0 +1,222 @@
+#include "OcclusionQueries.hpp"
+
+#include <utility>
+
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+
+namespace Diligent
+{
+
+namespace
+{
+
+// clang-format off
+constexpr float3 BoxVerts[] =
+{
+    float3{-1, -1, -1}, float3{+1, -1, -1}, float3{+1, +1, -1}, float3{-1, +1, -1},
+    float3{-1, -1, +1}, float3{+1, -1, +1}, float3{+1, +1, +1}, float3{-1, +1, +1}
+};
+
+// Winding does not matter, boxes are drawn without culling
+constexpr Uint32 BoxIndices[] =
+{
+    0,1,2, 0,2,3,
+    4,6,5, 4,7,6,
+    0,4,5, 0,5,1,
+    1,5,6, 1,6,2,
+    2,6,7, 2,7,3,
+    3,7,4, 3,4,0
+};
+// clang-format on
+
+} // namespace
+
+bool OcclusionQueries::IsSupported(IRenderDevice* pDevice)
+{
+    return pDevice->GetDeviceInfo().Features.OcclusionQueries != DEVICE_FEATURE_STATE_DISABLED;
+}
+
+OcclusionQueries::OcclusionQueries(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice},
+    m_MaxQueriesPerFrame{CI.MaxQueriesPerFrame}
+{
+    IRenderDevice* pDevice = CI.pDevice;
+
+    CreateUniformBuffer(pDevice, sizeof(float4x4), "Occlusion box constants CB", &m_pConstants);
+
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name      = "Occlusion box vertex buffer";
+    VertBuffDesc.Usage     = USAGE_IMMUTABLE;
+    VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
+    VertBuffDesc.Size      = sizeof(BoxVerts);
+    BufferData VBData;
+    VBData.pData    = BoxVerts;
+    VBData.DataSize = sizeof(BoxVerts);
+    pDevice->CreateBuffer(VertBuffDesc, &VBData, &m_pVertexBuffer);
+
+    BufferDesc IndBuffDesc;
+    IndBuffDesc.Name      = "Occlusion box index buffer";
+    IndBuffDesc.Usage     = USAGE_IMMUTABLE;
+    IndBuffDesc.BindFlags = BIND_INDEX_BUFFER;
+    IndBuffDesc.Size      = sizeof(BoxIndices);
+    BufferData IBData;
+    IBData.pData    = BoxIndices;
+    IBData.DataSize = sizeof(BoxIndices);
+    pDevice->CreateBuffer(IndBuffDesc, &IBData, &m_pIndexBuffer);
+
+    GraphicsPipelineStateCreateInfo PSOCreateInfo;
+
+    PSOCreateInfo.PSODesc.Name         = "Occlusion box PSO";
+    PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_GRAPHICS;
+    PSOCreateInfo.pPSOCache            = CI.pPSOCache;
+
+    // clang-format off
+    PSOCreateInfo.GraphicsPipeline.NumRenderTargets             = 1;
+    PSOCreateInfo.GraphicsPipeline.RTVFormats[0]                = CI.RTVFormat;
+    PSOCreateInfo.GraphicsPipeline.DSVFormat                    = CI.DSVFormat;
+    PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    // Back faces keep the box testable if its front faces are clipped by the far plane
+    PSOCreateInfo.GraphicsPipeline.RasterizerDesc.CullMode      = CULL_MODE_NONE;
+    // Boxes are tested against the scene, but do not occlude each other
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable      = True;
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthWriteEnable = False;
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthFunc        = COMPARISON_FUNC_LESS_EQUAL;
+    // clang-format on
+
+    // The color target stays bound after the scene, but the boxes must not be visible
+    PSOCreateInfo.GraphicsPipeline.BlendDesc.RenderTargets[0].RenderTargetWriteMask = COLOR_MASK_NONE;
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage             = SHADER_SOURCE_LANGUAGE_HLSL;
+    ShaderCI.CompileFlags               = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+    ShaderCI.pShaderSourceStreamFactory = CI.pShaderSourceFactory;
+
+    // Only depth testing is needed, so there is no pixel shader
+    RefCntAutoPtr<IShader> pVS;
+    {
+        ShaderCI.Desc.ShaderType = SHADER_TYPE_VERTEX;
+        ShaderCI.EntryPoint      = "main";
+        ShaderCI.Desc.Name       = "Occlusion box VS";
+        ShaderCI.FilePath        = "occlusion_box.vsh";
+        pDevice->CreateShader(ShaderCI, &pVS);
+    }
+
+    // clang-format off
+    LayoutElement LayoutElems[] =
+    {
+        // Attribute 0 - position
+        LayoutElement{0, 0, 3, VT_FLOAT32, False}
+    };
+    // clang-format on
+
+    PSOCreateInfo.pVS = pVS;
+
+    PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = LayoutElems;
+    PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = _countof(LayoutElems);
+
+    PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+    pDevice->CreateGraphicsPipelineState(PSOCreateInfo, &m_pPSO);
+    m_pPSO->GetStaticVariableByName(SHADER_TYPE_VERTEX, "Constants")->Set(m_pConstants);
+    m_pPSO->CreateShaderResourceBinding(&m_pSRB, true);
+}
+
+void OcclusionQueries::BeginFrame(Uint32 NumObjects)
+{
+    ++m_Frame;
+    m_Objects.resize(NumObjects);
+    m_Boxes.clear();
+
+    // Queries that are not ready stay pending. Nothing waits for the GPU.
+    size_t NumPending = 0;
+    for (PendingQuery& Pending : m_PendingQueries)
+    {
+        QueryDataOcclusion Data;
+        if (!Pending.pQuery->GetData(&Data, sizeof(Data)))
+        {
+            if (&m_PendingQueries[NumPending] != &Pending)
+                m_PendingQueries[NumPending] = std::move(Pending);
+            ++NumPending;
+            continue;
+        }
+
+        // Objects removed since the query was issued are ignored
+        if (Pending.ObjectId < m_Objects.size())
+        {
+            ObjectState& Obj  = m_Objects[Pending.ObjectId];
+            Obj.Occluded      = Data.NumSamples == 0;
+            Obj.QueryInFlight = false;
+        }
+        m_FreeQueries.emplace_back(std::move(Pending.pQuery));
+    }
+    m_PendingQueries.resize(NumPending);
+}
+
+bool OcclusionQueries::IsOccluded(Uint32 ObjectId) const
+{
+    // A result is only trusted while the object stays in the tested set. Objects that come
+    // back after being culled by other tests have results that are too old.
+    const ObjectState& Obj = m_Objects[ObjectId];
+    return Obj.Occluded && Obj.LastTestedFrame + 1 == m_Frame;
+}
+
+void OcclusionQueries::Test(Uint32 ObjectId, const float4x4& BoxTransform)
+{
+    ObjectState& Obj = m_Objects[ObjectId];
+    if (Obj.LastTestedFrame + 1 != m_Frame)
+        Obj.Occluded = false;
+    Obj.LastTestedFrame = m_Frame;
+
+    // The latest result is kept until the query in flight is ready
+    if (Obj.QueryInFlight || m_Boxes.size() >= m_MaxQueriesPerFrame)
+        return;
+
+    Obj.QueryInFlight = true;
+    m_Boxes.push_back({ObjectId, BoxTransform});
+}
+
+void OcclusionQueries::Render(IDeviceContext* pContext, const float4x4& ViewProj)
+{
+    if (m_Boxes.empty())
+        return;
+
+    const Uint64 offset   = 0;
+    IBuffer*     pBuffs[] = {m_pVertexBuffer};
+    pContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+    pContext->SetIndexBuffer(m_pIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    pContext->SetPipelineState(m_pPSO);
+
+    for (const QueuedBox& Box : m_Boxes)
+    {
+        RefCntAutoPtr<IQuery> pQuery;
+        if (!m_FreeQueries.empty())
+        {
+            pQuery = std::move(m_FreeQueries.back());
+            m_FreeQueries.pop_back();
+        }
+        else
+        {
+            QueryDesc Desc;
+            Desc.Name = "Occlusion box query";
+            Desc.Type = QUERY_TYPE_OCCLUSION;
+            m_pDevice->CreateQuery(Desc, &pQuery);
+        }
+
+        {
+            MapHelper<float4x4> CBConstants(pContext, m_pConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+            *CBConstants = Box.Transform * ViewProj;
+        }
+        pContext->CommitShaderResources(m_pSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        pContext->BeginQuery(pQuery);
+        DrawIndexedAttribs DrawAttrs{_countof(BoxIndices), VT_UINT32, DRAW_FLAG_VERIFY_ALL};
+        pContext->DrawIndexed(DrawAttrs);
+        pContext->EndQuery(pQuery);
+
+        m_PendingQueries.push_back({std::move(pQuery), Box.ObjectId});
+    }
+    m_Boxes.clear();
+}
+
+} // namespace Diligent
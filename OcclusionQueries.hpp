@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Hardware occlusion queries on the bounding boxes of objects.
+//
+// Every frame the boxes of the tested objects are drawn after the scene with depth testing
+// and no color or depth writes, each one inside its own occlusion query. Results are read
+// back in later frames without waiting for the GPU, so an object is skipped when the query
+// issued for it in an earlier frame found that no samples of its box passed the depth test.
+// Queries are taken from a pool, and an object gets no new query while its last one is
+// still in flight.
+class OcclusionQueries
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice*                   pDevice              = nullptr;
+        IShaderSourceInputStreamFactory* pShaderSourceFactory = nullptr;
+        TEXTURE_FORMAT                   RTVFormat            = TEX_FORMAT_UNKNOWN;
+        TEXTURE_FORMAT                   DSVFormat            = TEX_FORMAT_UNKNOWN;
+
+        // Maximum number of boxes drawn in one frame. Objects over the limit are not tested.
+        Uint32 MaxQueriesPerFrame = 1024;
+
+        // Optional cache the pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+    };
+
+    static bool IsSupported(IRenderDevice* pDevice);
+
+    explicit OcclusionQueries(const CreateInfo& CI);
+
+    // Reads back the results of the queries that are ready and starts a new frame.
+    // Must be called before IsOccluded() and Test().
+    void BeginFrame(Uint32 NumObjects);
+
+    // Returns true if the latest query of the object found its box hidden. Objects that
+    // were not tested in the previous frame are never reported as occluded.
+    bool IsOccluded(Uint32 ObjectId) const;
+
+    // Requests a query for the object with the [-1, 1] cube transformed by BoxTransform
+    // as its bounds. The box must not cross the near plane.
+    void Test(Uint32 ObjectId, const float4x4& BoxTransform);
+
+    // Draws the boxes of the frame with the scene's depth buffer bound
+    void Render(IDeviceContext* pContext, const float4x4& ViewProj);
+
+private:
+    struct ObjectState
+    {
+        bool   Occluded        = false;
+        bool   QueryInFlight   = false;
+        Uint64 LastTestedFrame = 0;
+    };
+
+    struct QueuedBox
+    {
+        Uint32   ObjectId;
+        float4x4 Transform;
+    };
+
+    struct PendingQuery
+    {
+        RefCntAutoPtr<IQuery> pQuery;
+        Uint32                ObjectId;
+    };
+
+    RefCntAutoPtr<IRenderDevice> m_pDevice;
+    const Uint32                 m_MaxQueriesPerFrame;
+
+    RefCntAutoPtr<IPipelineState>         m_pPSO;
+    RefCntAutoPtr<IShaderResourceBinding> m_pSRB;
+    RefCntAutoPtr<IBuffer>                m_pVertexBuffer;
+    RefCntAutoPtr<IBuffer>                m_pIndexBuffer;
+    RefCntAutoPtr<IBuffer>                m_pConstants;
+
+    // Starts at 1 so that no object counts as tested in the previous frame at first
+    Uint64                   m_Frame = 1;
+    std::vector<ObjectState> m_Objects;
+    std::vector<QueuedBox>   m_Boxes;
+
+    std::vector<RefCntAutoPtr<IQuery>> m_FreeQueries;
+    std::vector<PendingQuery>          m_PendingQueries;
+};
+
+} // namespace Diligent
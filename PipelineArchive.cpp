@@ -0,0 +1,284 @@
+#include "PipelineArchive.hpp"
+
+#include "ArchiverFactoryLoader.h"
+#include "DataBlobImpl.hpp"
+#include "FileWrapper.hpp"
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+const PipelineArchive::BackendInfo PipelineArchive::Backends[2] = {
+    {ARCHIVE_DEVICE_DATA_FLAG_VULKAN, RENDER_DEVICE_TYPE_VULKAN, "vk"},
+    {ARCHIVE_DEVICE_DATA_FLAG_GL, RENDER_DEVICE_TYPE_GL, "gl"},
+};
+
+PipelineArchive::PipelineArchive(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice},
+    m_FilePrefix{CI.FilePrefix},
+    m_ContentVersion{CI.ContentVersion},
+    m_pPSOCache{CI.pPSOCache},
+    m_pShaderOptimizer{CI.pShaderOptimizer}
+{
+    if (CI.Bake)
+    {
+#if EXPLICITLY_LOAD_ARCHIVER_FACTORY_DLL
+        auto GetArchiverFactory = LoadArchiverFactory();
+        if (GetArchiverFactory == nullptr)
+        {
+            LOG_ERROR_MESSAGE("Failed to load the archiver factory. Pipelines will not be baked.");
+            return;
+        }
+#endif
+        IArchiverFactory* pArchiverFactory = GetArchiverFactory();
+
+        // Pipelines are serialized with the features of the current device
+        SerializationDeviceCreateInfo DeviceCI;
+        DeviceCI.DeviceInfo  = m_pDevice->GetDeviceInfo();
+        DeviceCI.AdapterInfo = m_pDevice->GetAdapterInfo();
+        pArchiverFactory->CreateSerializationDevice(DeviceCI, &m_pSerializationDevice);
+        if (!m_pSerializationDevice)
+        {
+            LOG_ERROR_MESSAGE("Failed to create the serialization device. Pipelines will not be baked.");
+            return;
+        }
+
+        for (size_t i = 0; i < _countof(Backends); ++i)
+        {
+            RefCntAutoPtr<IArchiver> pArchiver;
+            pArchiverFactory->CreateArchiver(m_pSerializationDevice, &pArchiver);
+            m_Archivers.push_back(pArchiver);
+        }
+        // Pipelines being baked are always compiled from source
+        return;
+    }
+
+    for (const BackendInfo& Backend : Backends)
+    {
+        if (Backend.DeviceType != m_pDevice->GetDeviceInfo().Type)
+            continue;
+
+        const std::string FilePath = GetFilePath(Backend);
+        FileWrapper       File{FilePath.c_str(), EFileAccessMode::Read};
+        if (!File)
+        {
+            LOG_INFO_MESSAGE("Pipeline archive '", FilePath, "' is not found. Pipelines will be compiled from source.");
+            return;
+        }
+
+        RefCntAutoPtr<DataBlobImpl> pData = DataBlobImpl::Create(File->GetSize());
+        if (!File->Read(pData->GetDataPtr(), pData->GetSize()))
+        {
+            LOG_ERROR_MESSAGE("Failed to read pipeline archive '", FilePath, "'");
+            return;
+        }
+
+        DearchiverCreateInfo DearchiverCI;
+        CI.pEngineFactory->CreateDearchiver(DearchiverCI, &m_pDearchiver);
+        // Archives baked from other shader sources are rejected by the content version
+        if (!m_pDearchiver || !m_pDearchiver->LoadArchive(pData, m_ContentVersion))
+        {
+            LOG_INFO_MESSAGE("Pipeline archive '", FilePath, "' is out of date. Pipelines will be compiled from source.");
+            m_pDearchiver.Release();
+        }
+        return;
+    }
+}
+
+std::string PipelineArchive::GetFilePath(const BackendInfo& Backend) const
+{
+    return m_FilePrefix + "_" + Backend.FileSuffix + ".bin";
+}
+
+bool PipelineArchive::UnpackGraphicsPipeline(const char* Name, IPipelineState** ppPSO)
+{
+    if (!m_pDearchiver)
+        return false;
+
+    PipelineStateUnpackInfo UnpackInfo;
+    UnpackInfo.pDevice      = m_pDevice;
+    UnpackInfo.PipelineType = PIPELINE_TYPE_GRAPHICS;
+    UnpackInfo.Name         = Name;
+    UnpackInfo.pCache       = m_pPSOCache;
+    m_pDearchiver->UnpackPipelineState(UnpackInfo, ppPSO);
+    return *ppPSO != nullptr;
+}
+
+void PipelineArchive::CreateShader(const ShaderCreateInfo& ShaderCI, IShader** ppShader)
+{
+    const bool Optimize = m_pSerializationDevice && m_pShaderOptimizer != nullptr;
+
+    // The optimizer reads the bytecode of the render device shader, which is only
+    // available once it is compiled
+    ShaderCreateInfo DeviceCI = ShaderCI;
+    if (Optimize)
+        DeviceCI.CompileFlags &= ~SHADER_COMPILE_FLAG_ASYNCHRONOUS;
+    m_pDevice->CreateShader(DeviceCI, ppShader);
+    if (!m_pSerializationDevice || *ppShader == nullptr)
+        return;
+
+    ShaderCreateInfo SerializedCI = ShaderCI;
+    SerializedCI.CompileFlags &= ~SHADER_COMPILE_FLAG_ASYNCHRONOUS;
+
+    std::vector<RefCntAutoPtr<IShader>>& SerializedShaders = m_SerializedShaders[*ppShader];
+    SerializedShaders.resize(_countof(Backends));
+
+    // The Vulkan archive gets the optimized SPIR-V
+    std::vector<Uint32> OptimizedSPIRV;
+    if (Optimize)
+    {
+        const void* pBytecode    = nullptr;
+        Uint64      BytecodeSize = 0;
+        (*ppShader)->GetBytecode(&pBytecode, BytecodeSize);
+        if (m_pShaderOptimizer->Optimize(ShaderCI.Desc.Name, pBytecode, static_cast<size_t>(BytecodeSize), OptimizedSPIRV))
+        {
+            ShaderCreateInfo BytecodeCI = SerializedCI;
+            BytecodeCI.FilePath         = nullptr;
+            BytecodeCI.Source           = nullptr;
+            BytecodeCI.Macros           = {};
+            BytecodeCI.ByteCode         = OptimizedSPIRV.data();
+            BytecodeCI.ByteCodeSize     = OptimizedSPIRV.size() * sizeof(Uint32);
+
+            for (size_t i = 0; i < _countof(Backends); ++i)
+            {
+                if (Backends[i].DeviceType != RENDER_DEVICE_TYPE_VULKAN)
+                    continue;
+
+                ShaderArchiveInfo ArchiveInfo;
+                ArchiveInfo.DeviceFlags = Backends[i].DeviceFlag;
+                m_pSerializationDevice->CreateShader(BytecodeCI, ArchiveInfo, &SerializedShaders[i]);
+                if (!SerializedShaders[i])
+                    LOG_WARNING_MESSAGE("Failed to serialize the optimized SPIR-V of shader '", ShaderCI.Desc.Name, "'. The unoptimized shader is baked.");
+            }
+        }
+    }
+
+    // The serialization device compiles the source once for all other backends
+    ShaderArchiveInfo ArchiveInfo;
+    for (size_t i = 0; i < _countof(Backends); ++i)
+    {
+        if (!SerializedShaders[i])
+            ArchiveInfo.DeviceFlags |= Backends[i].DeviceFlag;
+    }
+    if (ArchiveInfo.DeviceFlags == ARCHIVE_DEVICE_DATA_FLAG_NONE)
+        return;
+
+    RefCntAutoPtr<IShader> pSerializedShader;
+    m_pSerializationDevice->CreateShader(SerializedCI, ArchiveInfo, &pSerializedShader);
+    for (RefCntAutoPtr<IShader>& pShader : SerializedShaders)
+    {
+        if (!pShader)
+            pShader = pSerializedShader;
+    }
+}
+
+IPipelineResourceSignature* PipelineArchive::GetSerializedSignature(IPipelineResourceSignature* pSignature)
+{
+    RefCntAutoPtr<IPipelineResourceSignature>& pSerialized = m_SerializedSignatures[pSignature];
+    if (!pSerialized)
+    {
+        ResourceSignatureArchiveInfo ArchiveInfo;
+        for (const BackendInfo& Backend : Backends)
+            ArchiveInfo.DeviceFlags |= Backend.DeviceFlag;
+        m_pSerializationDevice->CreatePipelineResourceSignature(pSignature->GetDesc(), ArchiveInfo, &pSerialized);
+    }
+    return pSerialized;
+}
+
+void PipelineArchive::CreateGraphicsPipeline(const GraphicsPipelineStateCreateInfo& PSOCreateInfo, IPipelineState** ppPSO)
+{
+    m_pDevice->CreateGraphicsPipelineState(PSOCreateInfo, ppPSO);
+    if (!m_pSerializationDevice || *ppPSO == nullptr)
+        return;
+
+    // Same pipeline with the serialized shaders and signatures
+    GraphicsPipelineStateCreateInfo SerializedCI = PSOCreateInfo;
+    SerializedCI.Flags &= ~PSO_CREATE_FLAG_ASYNCHRONOUS;
+    SerializedCI.pPSOCache = nullptr;
+
+    std::vector<IPipelineResourceSignature*> Signatures(PSOCreateInfo.ppResourceSignatures, PSOCreateInfo.ppResourceSignatures + PSOCreateInfo.ResourceSignaturesCount);
+    for (IPipelineResourceSignature*& pSignature : Signatures)
+        pSignature = GetSerializedSignature(pSignature);
+    SerializedCI.ppResourceSignatures = Signatures.data();
+
+    for (size_t i = 0; i < _countof(Backends); ++i)
+    {
+        // Shaders may differ between the backends
+        // clang-format off
+        IShader* const* ppDeviceShaders[] = {&PSOCreateInfo.pVS, &PSOCreateInfo.pPS, &PSOCreateInfo.pDS, &PSOCreateInfo.pHS, &PSOCreateInfo.pGS, &PSOCreateInfo.pAS, &PSOCreateInfo.pMS};
+        IShader**       ppShaders[]       = {&SerializedCI.pVS,  &SerializedCI.pPS,  &SerializedCI.pDS,  &SerializedCI.pHS,  &SerializedCI.pGS,  &SerializedCI.pAS,  &SerializedCI.pMS};
+        // clang-format on
+        for (size_t s = 0; s < _countof(ppShaders); ++s)
+        {
+            IShader* pDeviceShader = *ppDeviceShaders[s];
+            if (pDeviceShader != nullptr)
+            {
+                VERIFY(m_SerializedShaders.count(pDeviceShader) != 0, "The shader was not created by the archive");
+                *ppShaders[s] = m_SerializedShaders[pDeviceShader][i];
+            }
+        }
+
+        PipelineStateArchiveInfo ArchiveInfo;
+        ArchiveInfo.DeviceFlags = Backends[i].DeviceFlag;
+
+        RefCntAutoPtr<IPipelineState> pSerializedPSO;
+        m_pSerializationDevice->CreateGraphicsPipelineState(SerializedCI, ArchiveInfo, &pSerializedPSO);
+        if (pSerializedPSO)
+            m_Archivers[i]->AddPipelineState(pSerializedPSO);
+        else
+            LOG_ERROR_MESSAGE("Failed to serialize pipeline '", PSOCreateInfo.PSODesc.Name, "' for the ", Backends[i].FileSuffix, " archive");
+    }
+}
+
+bool PipelineArchive::Save()
+{
+    VERIFY(IsBaking(), "Only archives being baked can be saved");
+
+    bool Saved = true;
+    for (size_t i = 0; i < _countof(Backends); ++i)
+    {
+        const std::string FilePath = GetFilePath(Backends[i]);
+
+        RefCntAutoPtr<IDataBlob> pData;
+        m_Archivers[i]->SerializeToBlob(m_ContentVersion, &pData);
+
+        FileWrapper File{FilePath.c_str(), EFileAccessMode::Overwrite};
+        if (!pData || !File || !File->Write(pData->GetConstDataPtr(), pData->GetSize()))
+        {
+            LOG_ERROR_MESSAGE("Failed to write pipeline archive '", FilePath, "'");
+            Saved = false;
+            continue;
+        }
+        LOG_INFO_MESSAGE("Pipeline archive '", FilePath, "' is written");
+    }
+    return Saved;
+}
+
+Uint32 PipelineArchive::ComputeContentVersion(IShaderSourceInputStreamFactory* pShaderSourceFactory, const std::vector<const char*>& FilePaths, Uint32 Salt)
+{
+    // FNV-1a over the salt and the contents of all files
+    Uint32 Hash   = 2166136261u;
+    auto   Append = [&Hash](const void* pData, size_t Size) {
+        for (size_t i = 0; i < Size; ++i)
+            Hash = (Hash ^ static_cast<const Uint8*>(pData)[i]) * 16777619u;
+    };
+    Append(&Salt, sizeof(Salt));
+
+    for (const char* FilePath : FilePaths)
+    {
+        RefCntAutoPtr<IFileStream> pStream;
+        pShaderSourceFactory->CreateInputStream(FilePath, &pStream);
+        if (!pStream)
+        {
+            LOG_ERROR_MESSAGE("Failed to open shader source '", FilePath, "'");
+            continue;
+        }
+
+        std::vector<Uint8> Source(pStream->GetSize());
+        if (!Source.empty() && pStream->Read(Source.data(), Source.size()))
+            Append(Source.data(), Source.size());
+    }
+    return Hash;
+}
+
+} // namespace Diligent
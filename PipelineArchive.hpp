@@ -0,0 +1,104 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "EngineFactory.h"
+#include "RenderDevice.h"
+#include "Dearchiver.h"
+#include "ArchiverFactory.h"
+#include "RefCntAutoPtr.hpp"
+#include "ShaderOptimizer.hpp"
+
+namespace Diligent
+{
+
+// Device object archives with the pipelines of the application, one file per backend.
+//
+// At run time, pipelines are unpacked from the archive of the current backend, which skips
+// the HLSL front-end and the conversion to SPIR-V or GLSL. If the archive is missing or was
+// baked from other shader sources, pipelines are compiled from source.
+//
+// When baking, shaders and pipelines are still created on the render device, and every one
+// of them is also serialized for all backends in Backends. Save() then writes the archives.
+// With a shader optimizer, the shaders of the Vulkan archive are baked from the optimized
+// SPIR-V of the render device shaders, so the optimization costs nothing at run time.
+class PipelineArchive
+{
+public:
+    struct CreateInfo
+    {
+        IEngineFactory* pEngineFactory = nullptr;
+        IRenderDevice*  pDevice        = nullptr;
+
+        // The archive of a backend is FilePrefix + "_<backend>.bin"
+        const char* FilePrefix = nullptr;
+
+        // Archives baked with another version are ignored
+        Uint32 ContentVersion = 0;
+
+        // Optional cache the unpacked pipelines are created through
+        IPipelineStateCache* pPSOCache = nullptr;
+
+        // Optional optimizer the SPIR-V of the shaders baked into the Vulkan archive goes
+        // through. Requires a Vulkan render device. Only used when baking.
+        ShaderOptimizer* pShaderOptimizer = nullptr;
+
+        bool Bake = false;
+    };
+
+    struct BackendInfo
+    {
+        ARCHIVE_DEVICE_DATA_FLAGS DeviceFlag;
+        RENDER_DEVICE_TYPE        DeviceType;
+        const char*               FileSuffix;
+    };
+    // Backends the archives are baked for
+    static const BackendInfo Backends[2];
+
+    explicit PipelineArchive(const CreateInfo& CI);
+
+    bool IsLoaded() const { return m_pDearchiver != nullptr; }
+    bool IsBaking() const { return m_pSerializationDevice != nullptr; }
+
+    // Unpacks the graphics pipeline with the given name. Returns false if the archive is not
+    // loaded or does not contain the pipeline, in which case it must be created from source.
+    bool UnpackGraphicsPipeline(const char* Name, IPipelineState** ppPSO);
+
+    // Create the objects on the render device and, when baking, serialize them as well.
+    // Signatures of the pipeline are serialized from their descriptions.
+    void CreateShader(const ShaderCreateInfo& ShaderCI, IShader** ppShader);
+    void CreateGraphicsPipeline(const GraphicsPipelineStateCreateInfo& PSOCreateInfo, IPipelineState** ppPSO);
+
+    // Writes the archives of all backends. Only valid when baking.
+    bool Save();
+
+    // Hash of the shader source files, combined with the salt that should cover any
+    // application state that affects the pipelines.
+    static Uint32 ComputeContentVersion(IShaderSourceInputStreamFactory* pShaderSourceFactory, const std::vector<const char*>& FilePaths, Uint32 Salt);
+
+private:
+    std::string GetFilePath(const BackendInfo& Backend) const;
+
+    IPipelineResourceSignature* GetSerializedSignature(IPipelineResourceSignature* pSignature);
+
+    IRenderDevice* const m_pDevice;
+    const std::string    m_FilePrefix;
+    const Uint32         m_ContentVersion;
+    IPipelineStateCache* m_pPSOCache;
+    ShaderOptimizer*     m_pShaderOptimizer;
+
+    RefCntAutoPtr<IDearchiver> m_pDearchiver;
+
+    RefCntAutoPtr<ISerializationDevice> m_pSerializationDevice;
+    // One archiver per entry of Backends
+    std::vector<RefCntAutoPtr<IArchiver>> m_Archivers;
+
+    // Serialized counterparts of the objects created on the render device.
+    // Shaders have one entry per entry of Backends.
+    std::map<IShader*, std::vector<RefCntAutoPtr<IShader>>>                          m_SerializedShaders;
+    std::map<IPipelineResourceSignature*, RefCntAutoPtr<IPipelineResourceSignature>> m_SerializedSignatures;
+};
+
+} // namespace Diligent
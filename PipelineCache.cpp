@@ -0,0 +1,129 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "FileWrapper.hpp"
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+namespace
+{
+
+constexpr Uint32 PipelineCacheFileMagic = 0x43505344; // 'DSPC'
+
+} // namespace
+
+PersistentPipelineCache::FileHeader PersistentPipelineCache::FileHeader::Create(IRenderDevice* pDevice, Uint32 ContentVersion)
+{
+    const RenderDeviceInfo&    DeviceInfo  = pDevice->GetDeviceInfo();
+    const GraphicsAdapterInfo& AdapterInfo = pDevice->GetAdapterInfo();
+
+    FileHeader Header;
+    Header.Magic          = PipelineCacheFileMagic;
+    Header.Version        = CurrentVersion;
+    Header.DeviceType     = static_cast<Uint32>(DeviceInfo.Type);
+    Header.APIVersion     = (DeviceInfo.APIVersion.Major << 16u) | DeviceInfo.APIVersion.Minor;
+    Header.VendorId       = AdapterInfo.VendorId;
+    Header.DeviceId       = AdapterInfo.DeviceId;
+    Header.ContentVersion = ContentVersion;
+    // On OpenGL, the adapter description is the GL_RENDERER string
+    strncpy(Header.AdapterName, AdapterInfo.Description, sizeof(Header.AdapterName) - 1);
+    return Header;
+}
+
+bool PersistentPipelineCache::FileHeader::IsCompatibleWith(const FileHeader& Other) const
+{
+    // clang-format off
+    return Magic          == Other.Magic          &&
+           Version        == Other.Version        &&
+           DeviceType     == Other.DeviceType     &&
+           APIVersion     == Other.APIVersion     &&
+           VendorId       == Other.VendorId       &&
+           DeviceId       == Other.DeviceId       &&
+           ContentVersion == Other.ContentVersion &&
+           strncmp(AdapterName, Other.AdapterName, sizeof(AdapterName)) == 0;
+    // clang-format on
+}
+
+bool PersistentPipelineCache::IsSupported(IRenderDevice* pDevice)
+{
+    // OpenGL and GLES store program binaries, D3D11 has no pipeline caches the application can store
+    const RENDER_DEVICE_TYPE Type = pDevice->GetDeviceInfo().Type;
+    return Type != RENDER_DEVICE_TYPE_D3D11 && Type != RENDER_DEVICE_TYPE_UNDEFINED;
+}
+
+PersistentPipelineCache::PersistentPipelineCache(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice},
+    m_FilePath{CI.FilePath},
+    m_ContentVersion{CI.ContentVersion}
+{
+    if (!IsSupported(m_pDevice))
+        return;
+
+    const FileHeader   Header = FileHeader::Create(m_pDevice, m_ContentVersion);
+    std::vector<Uint8> Data;
+    {
+        FileWrapper File{m_FilePath.c_str(), EFileAccessMode::Read};
+        FileHeader  FileHdr;
+        if (!File)
+        {
+            LOG_INFO_MESSAGE("Pipeline cache '", m_FilePath, "' is not found. Pipelines will be compiled by the driver.");
+        }
+        else if (!File->Read(&FileHdr, sizeof(FileHdr)) || !Header.IsCompatibleWith(FileHdr) || FileHdr.DataSize != File->GetSize() - sizeof(FileHdr))
+        {
+            LOG_INFO_MESSAGE("Pipeline cache '", m_FilePath, "' was created for another device or other shaders and will be discarded.");
+        }
+        else
+        {
+            Data.resize(static_cast<size_t>(FileHdr.DataSize));
+            if (!Data.empty() && !File->Read(Data.data(), Data.size()))
+            {
+                LOG_ERROR_MESSAGE("Failed to read pipeline cache '", m_FilePath, "'");
+                Data.clear();
+            }
+        }
+    }
+
+    PipelineStateCacheCreateInfo CacheCI;
+    CacheCI.Desc.Name     = "Persistent pipeline cache";
+    CacheCI.Desc.Mode     = PSO_CACHE_MODE_LOAD_STORE;
+    CacheCI.pCacheData    = Data.empty() ? nullptr : Data.data();
+    CacheCI.CacheDataSize = static_cast<Uint32>(Data.size());
+    m_pDevice->CreatePipelineStateCache(CacheCI, &m_pCache);
+    if (!m_pCache)
+    {
+        // E.g. GL contexts that report no program binary formats
+        LOG_INFO_MESSAGE("Pipeline caches are not supported by the device. Pipelines will be compiled by the driver.");
+        return;
+    }
+
+    m_SavedDataSize = Data.size();
+}
+
+void PersistentPipelineCache::Save()
+{
+    if (!m_pCache)
+        return;
+
+    RefCntAutoPtr<IDataBlob> pData;
+    m_pCache->GetData(&pData);
+    // Caches only grow, so the same size means that no pipelines were added
+    if (!pData || pData->GetSize() == m_SavedDataSize)
+        return;
+
+    FileHeader Header = FileHeader::Create(m_pDevice, m_ContentVersion);
+    Header.DataSize   = pData->GetSize();
+
+    FileWrapper File{m_FilePath.c_str(), EFileAccessMode::Overwrite};
+    if (!File || !File->Write(&Header, sizeof(Header)) || !File->Write(pData->GetConstDataPtr(), pData->GetSize()))
+    {
+        LOG_ERROR_MESSAGE("Failed to write pipeline cache '", m_FilePath, "'");
+        return;
+    }
+    m_SavedDataSize = pData->GetSize();
+}
+
+} // namespace Diligent
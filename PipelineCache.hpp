@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+
+namespace Diligent
+{
+
+// Pipeline state cache that persists between runs of the application.
+//
+// The cache data is loaded from a file when the cache is created, and pipelines created
+// through the cache reuse the compiled driver pipelines of earlier runs. The file starts
+// with the identity of the device. If it does not match the current device, the data is
+// discarded and the cache starts empty. Driver updates are detected by the driver itself,
+// which ignores cache data with a different pipeline cache UUID.
+//
+// On OpenGL, the cache holds the linked program binaries (glGetProgramBinary) of the pipelines.
+// The driver rejects binaries of another driver version, and the engine then links the
+// program from source. The content version discards the data when the shader sources change,
+// since GL programs are looked up by their sources and stale binaries would otherwise pile up.
+class PersistentPipelineCache
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice* pDevice  = nullptr;
+        const char*    FilePath = nullptr;
+
+        // Hash of the shader sources and macros. Data saved with another version is discarded.
+        Uint32 ContentVersion = 0;
+    };
+
+    // Returns false if the backend has no pipeline state caches or program binaries
+    static bool IsSupported(IRenderDevice* pDevice);
+
+    explicit PersistentPipelineCache(const CreateInfo& CI);
+
+    // Null if caches are not supported
+    IPipelineStateCache* GetCache() const { return m_pCache; }
+
+    // Writes the cache to the file, unless its data have not changed since the last save
+    void Save();
+
+private:
+    struct FileHeader
+    {
+        // Must be incremented when the header changes
+        static constexpr Uint32 CurrentVersion = 2;
+
+        Uint32 Magic            = 0;
+        Uint32 Version          = 0;
+        Uint32 DeviceType       = 0;
+        Uint32 APIVersion       = 0;
+        Uint32 VendorId         = 0;
+        Uint32 DeviceId         = 0;
+        Uint32 ContentVersion   = 0;
+        char   AdapterName[128] = {};
+        Uint64 DataSize         = 0;
+
+        static FileHeader Create(IRenderDevice* pDevice, Uint32 ContentVersion);
+        bool              IsCompatibleWith(const FileHeader& Other) const;
+    };
+
+    IRenderDevice* const m_pDevice;
+    const std::string    m_FilePath;
+    const Uint32         m_ContentVersion;
+
+    RefCntAutoPtr<IPipelineStateCache> m_pCache;
+
+    // Size of the data in the file, used to skip saving unchanged caches
+    size_t m_SavedDataSize = 0;
+};
+
+} // namespace Diligent
@@ -0,0 +1,148 @@
+#include "SceneBatching.hpp"
+
+#include "DebugUtilities.hpp"
+
+namespace Diligent
+{
+
+namespace
+{
+
+// pDstPositions is optional and receives a copy of the transformed positions
+void TransformMesh(const MeshData& Mesh,
+                   const float4x4& Transform,
+                   Uint32          BaseVertex,
+                   MeshVertex*     pDstVertices,
+                   float3*         pDstPositions,
+                   Uint32*         pDstIndices)
+{
+    for (Uint32 v = 0; v < Mesh.NumVertices; ++v)
+    {
+        const MeshVertex& Src = Mesh.pVertices[v];
+        const float4      Pos = float4{Src.pos, 1} * Transform;
+
+        pDstVertices[v].pos = float3{Pos.x, Pos.y, Pos.z};
+        pDstVertices[v].uv  = Src.uv;
+        if (pDstPositions != nullptr)
+            pDstPositions[v] = float3{Pos.x, Pos.y, Pos.z};
+    }
+
+    for (Uint32 i = 0; i < Mesh.NumIndices; ++i)
+        pDstIndices[i] = BaseVertex + Mesh.pIndices[i];
+}
+
+} // namespace
+
+StaticBatch::StaticBatch(GeometryPool&   Pool,
+                         IDeviceContext* pContext,
+                         const MeshData& Mesh,
+                         const Instance* pInstances,
+                         Uint32          NumInstances) :
+    m_Pool{Pool}
+{
+    VERIFY_EXPR(NumInstances > 0);
+
+    std::vector<MeshVertex> Vertices(size_t{Mesh.NumVertices} * NumInstances);
+    std::vector<Uint32>     Indices(size_t{Mesh.NumIndices} * NumInstances);
+    for (Uint32 i = 0; i < NumInstances; ++i)
+    {
+        TransformMesh(Mesh, pInstances[i].LocalTransform, i * Mesh.NumVertices,
+                      &Vertices[size_t{i} * Mesh.NumVertices], nullptr,
+                      &Indices[size_t{i} * Mesh.NumIndices]);
+    }
+
+    MeshData BatchMesh;
+    BatchMesh.pVertices   = Vertices.data();
+    BatchMesh.NumVertices = static_cast<Uint32>(Vertices.size());
+    BatchMesh.pIndices    = Indices.data();
+    BatchMesh.NumIndices  = static_cast<Uint32>(Indices.size());
+    m_Mesh                = m_Pool.Allocate(pContext, BatchMesh);
+}
+
+StaticBatch::~StaticBatch()
+{
+    m_Pool.Release(m_Mesh);
+}
+
+
+DynamicBatch::DynamicBatch(IRenderDevice* pDevice,
+                           const char*    Name,
+                           Uint32         MaxVertices,
+                           Uint32         MaxIndices,
+                           bool           PositionStream) :
+    // clang-format off
+    m_MaxVertices{MaxVertices},
+    m_MaxIndices {MaxIndices}
+// clang-format on
+{
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name           = Name;
+    VertBuffDesc.Usage          = USAGE_DYNAMIC;
+    VertBuffDesc.BindFlags      = BIND_VERTEX_BUFFER;
+    VertBuffDesc.CPUAccessFlags = CPU_ACCESS_WRITE;
+    VertBuffDesc.Size           = Uint64{MaxVertices} * sizeof(MeshVertex);
+    pDevice->CreateBuffer(VertBuffDesc, nullptr, &m_pVertexBuffer);
+
+    if (PositionStream)
+    {
+        VertBuffDesc.Size = Uint64{MaxVertices} * sizeof(float3);
+        pDevice->CreateBuffer(VertBuffDesc, nullptr, &m_pPositionBuffer);
+    }
+
+    BufferDesc IndBuffDesc;
+    IndBuffDesc.Name           = Name;
+    IndBuffDesc.Usage          = USAGE_DYNAMIC;
+    IndBuffDesc.BindFlags      = BIND_INDEX_BUFFER;
+    IndBuffDesc.CPUAccessFlags = CPU_ACCESS_WRITE;
+    IndBuffDesc.Size           = Uint64{MaxIndices} * sizeof(Uint32);
+    pDevice->CreateBuffer(IndBuffDesc, nullptr, &m_pIndexBuffer);
+}
+
+void DynamicBatch::Begin(IDeviceContext* pContext)
+{
+    VERIFY(m_pContext == nullptr, "Begin() is called twice without End()");
+    m_pContext    = pContext;
+    m_NumVertices = 0;
+    m_NumIndices  = 0;
+
+    PVoid pData = nullptr;
+    m_pContext->MapBuffer(m_pVertexBuffer, MAP_WRITE, MAP_FLAG_DISCARD, pData);
+    m_pVertices = static_cast<MeshVertex*>(pData);
+    if (m_pPositionBuffer)
+    {
+        m_pContext->MapBuffer(m_pPositionBuffer, MAP_WRITE, MAP_FLAG_DISCARD, pData);
+        m_pPositions = static_cast<float3*>(pData);
+    }
+    m_pContext->MapBuffer(m_pIndexBuffer, MAP_WRITE, MAP_FLAG_DISCARD, pData);
+    m_pIndices = static_cast<Uint32*>(pData);
+}
+
+bool DynamicBatch::Append(const MeshData& Mesh, const float4x4& Transform)
+{
+    VERIFY(m_pContext != nullptr, "Append() must be called between Begin() and End()");
+    if (m_NumVertices + Mesh.NumVertices > m_MaxVertices || m_NumIndices + Mesh.NumIndices > m_MaxIndices)
+        return false;
+
+    // Mapped memory may be write-combined, so positions are written directly rather than copied back
+    TransformMesh(Mesh, Transform, m_NumVertices, m_pVertices + m_NumVertices,
+                  m_pPositions != nullptr ? m_pPositions + m_NumVertices : nullptr,
+                  m_pIndices + m_NumIndices);
+    m_NumVertices += Mesh.NumVertices;
+    m_NumIndices += Mesh.NumIndices;
+    return true;
+}
+
+void DynamicBatch::End()
+{
+    VERIFY(m_pContext != nullptr, "End() is called without Begin()");
+    m_pContext->UnmapBuffer(m_pIndexBuffer, MAP_WRITE);
+    m_pContext->UnmapBuffer(m_pVertexBuffer, MAP_WRITE);
+    if (m_pPositionBuffer)
+        m_pContext->UnmapBuffer(m_pPositionBuffer, MAP_WRITE);
+    m_pVertices  = nullptr;
+    m_pPositions = nullptr;
+    m_pIndices   = nullptr;
+    m_pContext   = nullptr;
+}
+
+} // namespace Diligent
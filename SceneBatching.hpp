@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "RefCntAutoPtr.hpp"
+#include "MeshData.hpp"
+#include "GeometryPool.hpp"
+
+namespace Diligent
+{
+
+// Objects that never move relative to each other and share a mesh and a material
+// are pre-transformed into the space of their common scene node and merged into a
+// single mesh in the geometry pool. The batch is then drawn with the node's
+// transform as one draw call.
+class StaticBatch
+{
+public:
+    struct Instance
+    {
+        // Transform from the object's space to the batch (scene node) space
+        float4x4 LocalTransform;
+    };
+
+    StaticBatch(GeometryPool&   Pool,
+                IDeviceContext* pContext,
+                const MeshData& Mesh,
+                const Instance* pInstances,
+                Uint32          NumInstances);
+
+    ~StaticBatch();
+
+    // clang-format off
+    StaticBatch           (const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+    // clang-format on
+
+    const GeometryPool::MeshHandle& GetMesh() const { return m_Mesh; }
+
+private:
+    GeometryPool&            m_Pool;
+    GeometryPool::MeshHandle m_Mesh;
+};
+
+
+// Small moving objects are transformed to world space on the CPU every frame and
+// streamed into one dynamic vertex/index buffer pair, so that any number of them
+// costs a single draw call. This does not rely on instancing and works on every backend.
+class DynamicBatch
+{
+public:
+    // If PositionStream is true, positions are also written to a separate
+    // tightly packed buffer for depth-only passes.
+    DynamicBatch(IRenderDevice* pDevice,
+                 const char*    Name,
+                 Uint32         MaxVertices,
+                 Uint32         MaxIndices,
+                 bool           PositionStream);
+
+    // Maps the buffers for writing. Must be paired with End().
+    void Begin(IDeviceContext* pContext);
+
+    // Appends the mesh transformed by Transform. Returns false if the batch
+    // does not have enough space left, in which case nothing is written.
+    bool Append(const MeshData& Mesh, const float4x4& Transform);
+
+    void End();
+
+    IBuffer* GetVertexBuffer() const { return m_pVertexBuffer; }
+    IBuffer* GetIndexBuffer() const { return m_pIndexBuffer; }
+    // Null unless the batch was created with a position stream
+    IBuffer* GetPositionBuffer() const { return m_pPositionBuffer; }
+    Uint32   GetNumIndices() const { return m_NumIndices; }
+
+private:
+    RefCntAutoPtr<IBuffer> m_pVertexBuffer;
+    RefCntAutoPtr<IBuffer> m_pPositionBuffer;
+    RefCntAutoPtr<IBuffer> m_pIndexBuffer;
+
+    const Uint32 m_MaxVertices;
+    const Uint32 m_MaxIndices;
+
+    IDeviceContext* m_pContext    = nullptr;
+    MeshVertex*     m_pVertices   = nullptr;
+    float3*         m_pPositions  = nullptr;
+    Uint32*         m_pIndices    = nullptr;
+    Uint32          m_NumVertices = 0;
+    Uint32          m_NumIndices  = 0;
+};
+
+} // namespace Diligent
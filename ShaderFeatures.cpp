@@ -0,0 +1,47 @@
+#include "ShaderFeatures.hpp"
+
+namespace Diligent
+{
+
+bool ShaderFeatures::SpecializationConstantsSupported(IRenderDevice* pDevice)
+{
+    return pDevice->GetDeviceInfo().Features.SpecializationConstants == DEVICE_FEATURE_STATE_ENABLED;
+}
+
+void ShaderFeatures::AddBool(const char* Name, SHADER_TYPE ShaderStages, bool Value)
+{
+    m_Features.push_back({Name, ShaderStages, Value ? 1 : 0});
+}
+
+void ShaderFeatures::AddInt(const char* Name, SHADER_TYPE ShaderStages, Int32 Value)
+{
+    m_Features.push_back({Name, ShaderStages, Value});
+}
+
+void ShaderFeatures::AddShaderMacros(ShaderMacroHelper& Macros) const
+{
+    if (m_UseSpecializationConstants)
+    {
+        Macros.AddShaderMacro("SHADER_FEATURES_SPECIALIZATION_CONSTANTS", 1);
+        return;
+    }
+
+    Macros.AddShaderMacro("SHADER_FEATURES_SPECIALIZATION_CONSTANTS", 0);
+    for (const Feature& Feat : m_Features)
+        Macros.AddShaderMacro((Feat.Name + "_VALUE").c_str(), Feat.Value);
+}
+
+void ShaderFeatures::SetSpecializationConstants(PipelineStateCreateInfo& PSOCreateInfo) const
+{
+    if (!m_UseSpecializationConstants)
+        return;
+
+    m_Constants.clear();
+    for (const Feature& Feat : m_Features)
+        m_Constants.emplace_back(Feat.Name.c_str(), Feat.ShaderStages, Uint32{sizeof(Feat.Value)}, &Feat.Value);
+
+    PSOCreateInfo.pSpecializationConstants   = m_Constants.data();
+    PSOCreateInfo.NumSpecializationConstants = static_cast<Uint32>(m_Constants.size());
+}
+
+} // namespace Diligent
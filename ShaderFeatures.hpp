@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "ShaderMacroHelper.hpp"
+
+namespace Diligent
+{
+
+// Feature switches of the shaders of a pipeline.
+//
+// Shaders declare every switch with SHADER_FEATURE_BOOL or SHADER_FEATURE_INT from
+// shader_features.fxh. When the device supports specialization constants, switches are
+// specialization constants: shaders are compiled once and the values are only applied when
+// the pipeline is created, so adding switches does not multiply shader compilations.
+// Otherwise every switch is a macro, and each combination of values is a separate shader.
+class ShaderFeatures
+{
+public:
+    // Returns true if switches can be specialization constants on the device
+    static bool SpecializationConstantsSupported(IRenderDevice* pDevice);
+
+    explicit ShaderFeatures(bool UseSpecializationConstants) :
+        m_UseSpecializationConstants{UseSpecializationConstants}
+    {}
+
+    void AddBool(const char* Name, SHADER_TYPE ShaderStages, bool Value);
+    void AddInt(const char* Name, SHADER_TYPE ShaderStages, Int32 Value);
+
+    // Adds the macros that select the implementation of the switches in shader_features.fxh.
+    // Without specialization constants, these are also the values of the switches.
+    void AddShaderMacros(ShaderMacroHelper& Macros) const;
+
+    // Sets the values of the switches in the pipeline. The pipeline must be created while
+    // this object is alive.
+    void SetSpecializationConstants(PipelineStateCreateInfo& PSOCreateInfo) const;
+
+    bool UsesSpecializationConstants() const { return m_UseSpecializationConstants; }
+
+private:
+    struct Feature
+    {
+        std::string Name;
+        SHADER_TYPE ShaderStages = SHADER_TYPE_UNKNOWN;
+        // Specialization constants of both types are 32-bit
+        Int32 Value = 0;
+    };
+
+    const bool m_UseSpecializationConstants;
+
+    std::vector<Feature> m_Features;
+
+    mutable std::vector<SpecializationConstant> m_Constants;
+};
+
+} // namespace Diligent
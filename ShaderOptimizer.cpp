@@ -0,0 +1,109 @@
+#include "ShaderOptimizer.hpp"
+
+#include "DebugUtilities.hpp"
+
+#if VULKAN_SUPPORTED
+#    include "spirv-tools/optimizer.hpp"
+#endif
+
+namespace Diligent
+{
+
+namespace
+{
+
+#if VULKAN_SUPPORTED
+
+// Number of instructions in the SPIR-V module. The first five words are the header,
+// and the high half of the first word of every instruction is its length in words.
+Uint32 CountInstructions(const Uint32* pWords, size_t NumWords)
+{
+    Uint32 NumInstructions = 0;
+    for (size_t i = 5; i < NumWords; ++NumInstructions)
+    {
+        const Uint32 WordCount = pWords[i] >> 16u;
+        if (WordCount == 0)
+            break;
+        i += WordCount;
+    }
+    return NumInstructions;
+}
+
+spv_target_env GetTargetEnv(IRenderDevice* pDevice)
+{
+    const Version& APIVersion = pDevice->GetDeviceInfo().APIVersion;
+    if (APIVersion >= Version{1, 3})
+        return SPV_ENV_VULKAN_1_3;
+    if (APIVersion >= Version{1, 2})
+        return SPV_ENV_VULKAN_1_2;
+    if (APIVersion >= Version{1, 1})
+        return SPV_ENV_VULKAN_1_1;
+    return SPV_ENV_VULKAN_1_0;
+}
+
+#endif
+
+} // namespace
+
+bool ShaderOptimizer::IsSupported(IRenderDevice* pDevice)
+{
+#if VULKAN_SUPPORTED
+    return pDevice->GetDeviceInfo().IsVulkanDevice();
+#else
+    return false;
+#endif
+}
+
+ShaderOptimizer::ShaderOptimizer(const CreateInfo& CI) :
+    m_pDevice{CI.pDevice}
+{
+    VERIFY(IsSupported(m_pDevice), "Shaders of the device are not SPIR-V");
+}
+
+bool ShaderOptimizer::Optimize(const char* ShaderName, const void* pBytecode, size_t BytecodeSize, std::vector<Uint32>& Optimized)
+{
+#if VULKAN_SUPPORTED
+    if (pBytecode == nullptr || BytecodeSize == 0)
+        return false;
+
+    const Uint32* pWords   = static_cast<const Uint32*>(pBytecode);
+    const size_t  NumWords = BytecodeSize / sizeof(Uint32);
+
+    spvtools::Optimizer Optimizer{GetTargetEnv(m_pDevice)};
+    Optimizer.SetMessageConsumer([ShaderName](spv_message_level_t Level, const char*, const spv_position_t&, const char* Message) {
+        if (Level <= SPV_MSG_ERROR)
+            LOG_ERROR_MESSAGE("SPIR-V optimizer: ", Message, " ('", ShaderName, "')");
+    });
+    Optimizer.RegisterPerformancePasses();
+    Optimizer.RegisterSizePasses();
+    // Removes resources and interface variables that are not used by the entry point,
+    // and unused trailing components of input arrays
+    Optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(/*preserve_interface = */ false));
+    Optimizer.RegisterPass(spvtools::CreateEliminateDeadInputComponentsSafePass());
+    Optimizer.RegisterPass(spvtools::CreateCompactIdsPass());
+
+    Optimized.clear();
+    if (!Optimizer.Run(pWords, NumWords, &Optimized))
+    {
+        LOG_WARNING_MESSAGE("Failed to optimize the SPIR-V of shader '", ShaderName, "'");
+        return false;
+    }
+
+    const Uint32 InstructionsBefore = CountInstructions(pWords, NumWords);
+    const Uint32 InstructionsAfter  = CountInstructions(Optimized.data(), Optimized.size());
+    const size_t OptimizedSize      = Optimized.size() * sizeof(Uint32);
+    LOG_INFO_MESSAGE("SPIR-V of shader '", ShaderName, "': ", InstructionsBefore, " -> ", InstructionsAfter, " instructions, ",
+                     BytecodeSize, " -> ", OptimizedSize, " bytes");
+
+    m_Stats.NumShaders += 1;
+    m_Stats.InstructionsBefore += InstructionsBefore;
+    m_Stats.InstructionsAfter += InstructionsAfter;
+    m_Stats.BytesBefore += BytecodeSize;
+    m_Stats.BytesAfter += OptimizedSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace Diligent
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace Diligent
+{
+
+// Offline optimization stage for SPIR-V, run when the pipeline archive is baked.
+//
+// The SPIR-V of a compiled shader is run through the performance and size passes of the
+// SPIRV-Tools optimizer, which also strip resources and interface variables the shader never
+// reads. Names are kept, since the engine binds resources by name. Shaders compiled at run
+// time are not touched, so they can still be compiled asynchronously.
+class ShaderOptimizer
+{
+public:
+    struct CreateInfo
+    {
+        IRenderDevice* pDevice = nullptr;
+    };
+
+    struct Statistics
+    {
+        Uint32 NumShaders = 0;
+        // Totals over all optimized shaders
+        Uint64 InstructionsBefore = 0;
+        Uint64 InstructionsAfter  = 0;
+        Uint64 BytesBefore        = 0;
+        Uint64 BytesAfter         = 0;
+    };
+
+    // Returns true if the shaders of the device are SPIR-V
+    static bool IsSupported(IRenderDevice* pDevice);
+
+    explicit ShaderOptimizer(const CreateInfo& CI);
+
+    // Runs the passes over the SPIR-V of the shader. Returns false if it can not be optimized.
+    bool Optimize(const char* ShaderName, const void* pBytecode, size_t BytecodeSize, std::vector<Uint32>& Optimized);
+
+    const Statistics& GetStatistics() const { return m_Stats; }
+
+private:
+    IRenderDevice* const m_pDevice;
+
+    Statistics m_Stats;
+};
+
+} // namespace Diligent
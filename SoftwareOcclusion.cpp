@@ -0,0 +1,387 @@
+#include "SoftwareOcclusion.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "Align.hpp"
+#include "WorkerPool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define SOFTWARE_OCCLUSION_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define SOFTWARE_OCCLUSION_NEON 1
+#endif
+
+namespace Diligent
+{
+
+namespace
+{
+
+// Number of pixels processed by one SIMD instruction. Tile width is a multiple of it.
+constexpr int SimdWidth = 4;
+
+// Binning fewer triangles than this is not worth waking up a worker
+constexpr Uint32 MinTrianglesPerTask = 32;
+
+// Runs Task(0) ... Task(NumTasks - 1) on the pool, or on the calling thread if there is none
+void RunTasks(WorkerPool* pWorkerPool, Uint32 NumTasks, const std::function<void(Uint32)>& Task)
+{
+    if (pWorkerPool != nullptr)
+    {
+        pWorkerPool->Run(NumTasks, Task);
+        return;
+    }
+    for (Uint32 i = 0; i < NumTasks; ++i)
+        Task(i);
+}
+
+// Writes the triangle depth to the covered pixels out of the SimdWidth pixels that start at pDepth,
+// keeping the nearest depth. X and Y are the center of the first pixel.
+inline void RasterizePixels(float*       pDepth,
+                            float        X,
+                            float        Y,
+                            const float* EdgeA,
+                            const float* EdgeB,
+                            const float* EdgeC,
+                            float        DepthA,
+                            float        DepthB,
+                            float        DepthC)
+{
+#if SOFTWARE_OCCLUSION_SSE
+    const __m128 PX = _mm_add_ps(_mm_set1_ps(X), _mm_setr_ps(0, 1, 2, 3));
+    const __m128 PY = _mm_set1_ps(Y);
+
+    __m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int i = 0; i < 3; ++i)
+    {
+        __m128 Edge = _mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(EdgeA[i])), _mm_set1_ps(EdgeC[i]));
+        Edge        = _mm_add_ps(Edge, _mm_mul_ps(PY, _mm_set1_ps(EdgeB[i])));
+        Inside      = _mm_and_ps(Inside, _mm_cmpge_ps(Edge, _mm_setzero_ps()));
+    }
+    if (_mm_movemask_ps(Inside) == 0)
+        return;
+
+    __m128 Depth = _mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(DepthA)), _mm_set1_ps(DepthC));
+    Depth        = _mm_add_ps(Depth, _mm_mul_ps(PY, _mm_set1_ps(DepthB)));
+
+    const __m128 OldDepth = _mm_loadu_ps(pDepth);
+    const __m128 NewDepth = _mm_min_ps(OldDepth, Depth);
+    _mm_storeu_ps(pDepth, _mm_or_ps(_mm_and_ps(Inside, NewDepth), _mm_andnot_ps(Inside, OldDepth)));
+#elif SOFTWARE_OCCLUSION_NEON
+    static const float Offsets[] = {0, 1, 2, 3};
+
+    const float32x4_t PX = vaddq_f32(vdupq_n_f32(X), vld1q_f32(Offsets));
+    const float32x4_t PY = vdupq_n_f32(Y);
+
+    uint32x4_t Inside = vdupq_n_u32(~0u);
+    for (int i = 0; i < 3; ++i)
+    {
+        float32x4_t Edge = vmlaq_n_f32(vdupq_n_f32(EdgeC[i]), PX, EdgeA[i]);
+        Edge             = vmlaq_n_f32(Edge, PY, EdgeB[i]);
+        Inside           = vandq_u32(Inside, vcgeq_f32(Edge, vdupq_n_f32(0)));
+    }
+    if ((vgetq_lane_u32(Inside, 0) | vgetq_lane_u32(Inside, 1) | vgetq_lane_u32(Inside, 2) | vgetq_lane_u32(Inside, 3)) == 0)
+        return;
+
+    float32x4_t Depth = vmlaq_n_f32(vdupq_n_f32(DepthC), PX, DepthA);
+    Depth             = vmlaq_n_f32(Depth, PY, DepthB);
+
+    const float32x4_t OldDepth = vld1q_f32(pDepth);
+    vst1q_f32(pDepth, vbslq_f32(Inside, vminq_f32(OldDepth, Depth), OldDepth));
+#else
+    for (int p = 0; p < SimdWidth; ++p)
+    {
+        const float PX     = X + static_cast<float>(p);
+        bool        Inside = true;
+        for (int i = 0; i < 3; ++i)
+            Inside = Inside && (EdgeA[i] * PX + EdgeB[i] * Y + EdgeC[i] >= 0);
+        if (Inside)
+            pDepth[p] = std::min(pDepth[p], DepthA * PX + DepthB * Y + DepthC);
+    }
+#endif
+}
+
+// Returns true if any of the SimdWidth pixels that start at pDepth is not closer than Depth
+inline bool AnyPixelNotCloser(const float* pDepth, float Depth)
+{
+#if SOFTWARE_OCCLUSION_SSE
+    return _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(pDepth), _mm_set1_ps(Depth))) != 0;
+#elif SOFTWARE_OCCLUSION_NEON
+    const uint32x4_t NotCloser = vcgeq_f32(vld1q_f32(pDepth), vdupq_n_f32(Depth));
+    return (vgetq_lane_u32(NotCloser, 0) | vgetq_lane_u32(NotCloser, 1) | vgetq_lane_u32(NotCloser, 2) | vgetq_lane_u32(NotCloser, 3)) != 0;
+#else
+    for (int p = 0; p < SimdWidth; ++p)
+    {
+        if (pDepth[p] >= Depth)
+            return true;
+    }
+    return false;
+#endif
+}
+
+} // namespace
+
+SoftwareOcclusionCuller::SoftwareOcclusionCuller(const CreateInfo& CI) :
+    m_Width{AlignUp(std::max(CI.Width, 1u), TileWidth)},
+    m_Height{AlignUp(std::max(CI.Height, 1u), TileHeight)},
+    m_NumTilesX{m_Width / TileWidth},
+    m_NumTilesY{m_Height / TileHeight},
+    m_pWorkerPool{CI.pWorkerPool},
+    m_Depth(m_Width * m_Height, FLT_MAX),
+    m_TileMaxDepth(m_NumTilesX * m_NumTilesY, FLT_MAX)
+{
+}
+
+void SoftwareOcclusionCuller::BeginFrame(const float4x4& ViewProj)
+{
+    m_ViewProj = ViewProj;
+    m_Occluders.clear();
+}
+
+void SoftwareOcclusionCuller::AddOccluder(const MeshData& Mesh, const float4x4& World)
+{
+    m_Occluders.push_back({&Mesh, World * m_ViewProj});
+}
+
+void SoftwareOcclusionCuller::BinTriangles(Uint32 FirstTriangle, Uint32 EndTriangle, BinningContext& Context) const
+{
+    Context.Triangles.clear();
+    Context.TileBins.resize(m_NumTilesX * m_NumTilesY);
+    for (std::vector<Uint32>& Bin : Context.TileBins)
+        Bin.clear();
+
+    // Occluder that contains the first triangle of the range
+    Uint32 OccluderId = static_cast<Uint32>(std::upper_bound(m_OccluderTriangleOffsets.begin(), m_OccluderTriangleOffsets.end(), FirstTriangle) - m_OccluderTriangleOffsets.begin()) - 1;
+
+    // Screen-space position and NDC depth of every vertex of the current occluder
+    std::vector<float3> ScreenVerts;
+    std::vector<bool>   ValidVerts;
+    for (; OccluderId < m_Occluders.size() && m_OccluderTriangleOffsets[OccluderId] < EndTriangle; ++OccluderId)
+    {
+        const Occluder& Occ  = m_Occluders[OccluderId];
+        const MeshData& Mesh = *Occ.pMesh;
+
+        // Occluders split between ranges have their vertices transformed by every range
+        const Uint32 OccFirstTriangle = m_OccluderTriangleOffsets[OccluderId];
+        const Uint32 BeginIndex       = (std::max(FirstTriangle, OccFirstTriangle) - OccFirstTriangle) * 3;
+        const Uint32 EndIndex         = (std::min(EndTriangle, m_OccluderTriangleOffsets[OccluderId + 1]) - OccFirstTriangle) * 3;
+
+        ScreenVerts.resize(Mesh.NumVertices);
+        ValidVerts.resize(Mesh.NumVertices);
+        for (Uint32 v = 0; v < Mesh.NumVertices; ++v)
+        {
+            const float4 ClipPos = float4{Mesh.pVertices[v].pos, 1} * Occ.WorldViewProj;
+            // Triangles are not clipped. Vertices in front of the near plane of any API have
+            // non-negative depth, so triangles that touch other vertices are dropped, which
+            // only makes the occluders smaller.
+            ValidVerts[v] = ClipPos.w > 0 && ClipPos.z >= 0;
+            if (!ValidVerts[v])
+                continue;
+
+            const float InvW = 1.f / ClipPos.w;
+            ScreenVerts[v]   = float3{
+                (ClipPos.x * InvW * 0.5f + 0.5f) * static_cast<float>(m_Width),
+                (0.5f - ClipPos.y * InvW * 0.5f) * static_cast<float>(m_Height),
+                ClipPos.z * InvW,
+            };
+        }
+
+        for (Uint32 i = BeginIndex; i < EndIndex; i += 3)
+        {
+            Uint32 Idx[3] = {Mesh.pIndices[i], Mesh.pIndices[i + 1], Mesh.pIndices[i + 2]};
+            if (!ValidVerts[Idx[0]] || !ValidVerts[Idx[1]] || !ValidVerts[Idx[2]])
+                continue;
+
+            // Both windings are rasterized, so the occluder culling mode does not matter
+            float3 V[3] = {ScreenVerts[Idx[0]], ScreenVerts[Idx[1]], ScreenVerts[Idx[2]]};
+
+            float Area = (V[1].x - V[0].x) * (V[2].y - V[0].y) - (V[1].y - V[0].y) * (V[2].x - V[0].x);
+            if (Area < 0)
+            {
+                std::swap(V[1], V[2]);
+                Area = -Area;
+            }
+            if (Area < 1e-6f)
+                continue;
+
+            // Pixels whose centers are inside the bounding box
+            Triangle Tri;
+            Tri.MinX = std::max(static_cast<int>(std::ceil(std::min({V[0].x, V[1].x, V[2].x}) - 0.5f)), 0);
+            Tri.MinY = std::max(static_cast<int>(std::ceil(std::min({V[0].y, V[1].y, V[2].y}) - 0.5f)), 0);
+            Tri.MaxX = std::min(static_cast<int>(std::floor(std::max({V[0].x, V[1].x, V[2].x}) - 0.5f)), static_cast<int>(m_Width) - 1);
+            Tri.MaxY = std::min(static_cast<int>(std::floor(std::max({V[0].y, V[1].y, V[2].y}) - 0.5f)), static_cast<int>(m_Height) - 1);
+            if (Tri.MinX > Tri.MaxX || Tri.MinY > Tri.MaxY)
+                continue;
+
+            // Edge i goes from vertex i to vertex i + 1 and is positive inside the triangle.
+            // Divided by the area, it is the barycentric coordinate of the opposite vertex.
+            for (int e = 0; e < 3; ++e)
+            {
+                const float3& Start = V[e];
+                const float3& End   = V[(e + 1) % 3];
+                Tri.EdgeA[e]        = Start.y - End.y;
+                Tri.EdgeB[e]        = End.x - Start.x;
+                Tri.EdgeC[e]        = -(Tri.EdgeA[e] * Start.x + Tri.EdgeB[e] * Start.y);
+            }
+
+            // NDC depth is linear in screen space
+            const float InvArea = 1.f / Area;
+            Tri.DepthA          = (Tri.EdgeA[1] * V[0].z + Tri.EdgeA[2] * V[1].z + Tri.EdgeA[0] * V[2].z) * InvArea;
+            Tri.DepthB          = (Tri.EdgeB[1] * V[0].z + Tri.EdgeB[2] * V[1].z + Tri.EdgeB[0] * V[2].z) * InvArea;
+            Tri.DepthC          = (Tri.EdgeC[1] * V[0].z + Tri.EdgeC[2] * V[1].z + Tri.EdgeC[0] * V[2].z) * InvArea;
+
+            const Uint32 TriId = static_cast<Uint32>(Context.Triangles.size());
+            Context.Triangles.push_back(Tri);
+            for (Uint32 TileY = Tri.MinY / TileHeight; TileY <= Tri.MaxY / TileHeight; ++TileY)
+            {
+                for (Uint32 TileX = Tri.MinX / TileWidth; TileX <= Tri.MaxX / TileWidth; ++TileX)
+                    Context.TileBins[TileY * m_NumTilesX + TileX].push_back(TriId);
+            }
+        }
+    }
+}
+
+void SoftwareOcclusionCuller::RasterizeTile(Uint32 Tile)
+{
+    const int TileMinX = static_cast<int>((Tile % m_NumTilesX) * TileWidth);
+    const int TileMinY = static_cast<int>((Tile / m_NumTilesX) * TileHeight);
+    const int TileMaxX = TileMinX + static_cast<int>(TileWidth) - 1;
+    const int TileMaxY = TileMinY + static_cast<int>(TileHeight) - 1;
+
+    for (int y = TileMinY; y <= TileMaxY; ++y)
+        std::fill_n(&m_Depth[y * m_Width + TileMinX], TileWidth, FLT_MAX);
+
+    for (const BinningContext& Context : m_BinningContexts)
+    {
+        for (Uint32 TriId : Context.TileBins[Tile])
+        {
+            const Triangle& Tri = Context.Triangles[TriId];
+
+            // Pixels outside of the triangle fail the edge tests, so spans
+            // start at a multiple of the SIMD width.
+            const int MinX = std::max(Tri.MinX, TileMinX) & ~(SimdWidth - 1);
+            const int MaxX = std::min(Tri.MaxX, TileMaxX);
+            const int MinY = std::max(Tri.MinY, TileMinY);
+            const int MaxY = std::min(Tri.MaxY, TileMaxY);
+            for (int y = MinY; y <= MaxY; ++y)
+            {
+                float* pRow = &m_Depth[y * m_Width];
+                for (int x = MinX; x <= MaxX; x += SimdWidth)
+                {
+                    RasterizePixels(pRow + x, static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f,
+                                    Tri.EdgeA, Tri.EdgeB, Tri.EdgeC, Tri.DepthA, Tri.DepthB, Tri.DepthC);
+                }
+            }
+        }
+    }
+
+    float MaxDepth = 0;
+    for (int y = TileMinY; y <= TileMaxY; ++y)
+    {
+        const float* pRow = &m_Depth[y * m_Width + TileMinX];
+        MaxDepth          = std::max(MaxDepth, *std::max_element(pRow, pRow + TileWidth));
+    }
+    m_TileMaxDepth[Tile] = MaxDepth;
+}
+
+void SoftwareOcclusionCuller::Rasterize()
+{
+    m_OccluderTriangleOffsets.resize(m_Occluders.size() + 1);
+    Uint32 NumTriangles = 0;
+    for (size_t i = 0; i < m_Occluders.size(); ++i)
+    {
+        m_OccluderTriangleOffsets[i] = NumTriangles;
+        NumTriangles += m_Occluders[i].pMesh->NumIndices / 3;
+    }
+    m_OccluderTriangleOffsets.back() = NumTriangles;
+
+    const Uint32 NumThreads   = m_pWorkerPool != nullptr ? m_pWorkerPool->GetNumThreads() : 1;
+    const Uint32 NumTiles     = m_NumTilesX * m_NumTilesY;
+    const Uint32 NumBinTasks  = std::max(1u, std::min(NumThreads, NumTriangles / MinTrianglesPerTask));
+    const Uint32 NumTileTasks = std::min(NumThreads, NumTiles);
+
+    // Every task sets up and bins its own range of triangles, which may span several occluders
+    // or a part of one. Tiles are then rasterized in parallel, each one going through the bins
+    // of all tasks in triangle order.
+    m_BinningContexts.resize(NumBinTasks);
+    RunTasks(m_pWorkerPool, NumBinTasks, [&](Uint32 Task) {
+        BinTriangles(Task * NumTriangles / NumBinTasks, (Task + 1) * NumTriangles / NumBinTasks, m_BinningContexts[Task]);
+    });
+    RunTasks(m_pWorkerPool, NumTileTasks, [&](Uint32 Task) {
+        for (Uint32 Tile = Task; Tile < NumTiles; Tile += NumTileTasks)
+            RasterizeTile(Tile);
+    });
+}
+
+bool SoftwareOcclusionCuller::IsSphereOccluded(const float3& Center, float Radius) const
+{
+    if (m_Occluders.empty())
+        return false;
+
+    // Screen-space rectangle and nearest depth of the sphere's bounding box
+    float MinX = FLT_MAX, MinY = FLT_MAX, MinDepth = FLT_MAX;
+    float MaxX = -FLT_MAX, MaxY = -FLT_MAX;
+    for (Uint32 i = 0; i < 8; ++i)
+    {
+        const float3 Corner{
+            (i & 1u) != 0 ? Center.x + Radius : Center.x - Radius,
+            (i & 2u) != 0 ? Center.y + Radius : Center.y - Radius,
+            (i & 4u) != 0 ? Center.z + Radius : Center.z - Radius,
+        };
+
+        const float4 ClipPos = float4{Corner, 1} * m_ViewProj;
+        // The box crosses the camera plane and cannot be projected
+        if (ClipPos.w <= 0)
+            return false;
+
+        const float InvW = 1.f / ClipPos.w;
+        const float X    = (ClipPos.x * InvW * 0.5f + 0.5f) * static_cast<float>(m_Width);
+        const float Y    = (0.5f - ClipPos.y * InvW * 0.5f) * static_cast<float>(m_Height);
+        MinX             = std::min(MinX, X);
+        MaxX             = std::max(MaxX, X);
+        MinY             = std::min(MinY, Y);
+        MaxY             = std::max(MaxY, Y);
+        MinDepth         = std::min(MinDepth, ClipPos.z * InvW);
+    }
+
+    // Every pixel the rectangle touches is tested
+    const int RectMinX = std::max(static_cast<int>(std::floor(MinX)), 0);
+    const int RectMinY = std::max(static_cast<int>(std::floor(MinY)), 0);
+    const int RectMaxX = std::min(static_cast<int>(std::floor(MaxX)), static_cast<int>(m_Width) - 1);
+    const int RectMaxY = std::min(static_cast<int>(std::floor(MaxY)), static_cast<int>(m_Height) - 1);
+    // Off-screen objects are left to frustum culling
+    if (RectMinX > RectMaxX || RectMinY > RectMaxY)
+        return false;
+
+    for (Uint32 TileY = RectMinY / TileHeight; TileY <= RectMaxY / TileHeight; ++TileY)
+    {
+        for (Uint32 TileX = RectMinX / TileWidth; TileX <= RectMaxX / TileWidth; ++TileX)
+        {
+            // All pixels of the tile are closer than the object
+            if (m_TileMaxDepth[TileY * m_NumTilesX + TileX] < MinDepth)
+                continue;
+
+            // Spans are widened to the SIMD width, which can only keep the object visible
+            const int MinPX = std::max(RectMinX, static_cast<int>(TileX * TileWidth)) & ~(SimdWidth - 1);
+            const int MaxPX = std::min(RectMaxX, static_cast<int>((TileX + 1) * TileWidth) - 1);
+            const int MinPY = std::max(RectMinY, static_cast<int>(TileY * TileHeight));
+            const int MaxPY = std::min(RectMaxY, static_cast<int>((TileY + 1) * TileHeight) - 1);
+            for (int y = MinPY; y <= MaxPY; ++y)
+            {
+                const float* pRow = &m_Depth[y * m_Width];
+                for (int x = MinPX; x <= MaxPX; x += SimdWidth)
+                {
+                    if (AnyPixelNotCloser(pRow + x, MinDepth))
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace Diligent
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include "BasicMath.hpp"
+#include "MeshData.hpp"
+
+namespace Diligent
+{
+
+class WorkerPool;
+
+// Occlusion culling on the CPU with a software-rasterized depth buffer.
+//
+// A small set of occluder meshes is rasterized every frame into a low-resolution depth buffer,
+// four pixels per SIMD instruction. The buffer is split into tiles: ranges of occluder triangles
+// are set up and binned into the tiles in parallel, and then the tiles are rasterized in parallel.
+// Objects are tested by comparing the nearest depth of their bounds with the depth under their
+// screen rectangle, using the farthest depth of every tile to skip fully covered tiles.
+class SoftwareOcclusionCuller
+{
+public:
+    struct CreateInfo
+    {
+        // Size of the depth buffer. Rounded up to a multiple of the tile size.
+        Uint32 Width  = 256;
+        Uint32 Height = 128;
+
+        // Optional pool that binning and rasterization run on
+        WorkerPool* pWorkerPool = nullptr;
+    };
+
+    explicit SoftwareOcclusionCuller(const CreateInfo& CI);
+
+    // Clears the list of occluders and sets the view-projection matrix of the frame
+    void BeginFrame(const float4x4& ViewProj);
+
+    // Adds an occluder. The mesh data must stay alive until Rasterize() returns.
+    void AddOccluder(const MeshData& Mesh, const float4x4& World);
+
+    // Rasterizes all occluders added since BeginFrame()
+    void Rasterize();
+
+    // Returns true if the sphere is hidden behind the rasterized occluders
+    bool IsSphereOccluded(const float3& Center, float Radius) const;
+
+private:
+    static constexpr Uint32 TileWidth  = 32;
+    static constexpr Uint32 TileHeight = 16;
+
+    struct Occluder
+    {
+        const MeshData* pMesh;
+        float4x4        WorldViewProj;
+    };
+
+    // Screen-space triangle with its edge functions and depth plane, E(x, y) = A * x + B * y + C.
+    // A pixel is covered if all three edge functions are non-negative at its center.
+    struct Triangle
+    {
+        float EdgeA[3];
+        float EdgeB[3];
+        float EdgeC[3];
+        float DepthA, DepthB, DepthC;
+        int   MinX, MinY, MaxX, MaxY;
+    };
+
+    // Triangles and tile bins of one binning task
+    struct BinningContext
+    {
+        std::vector<Triangle>            Triangles;
+        std::vector<std::vector<Uint32>> TileBins;
+    };
+
+    // Sets up and bins the triangles [FirstTriangle, EndTriangle) of all occluders, in order
+    void BinTriangles(Uint32 FirstTriangle, Uint32 EndTriangle, BinningContext& Context) const;
+    void RasterizeTile(Uint32 Tile);
+
+    const Uint32 m_Width;
+    const Uint32 m_Height;
+    const Uint32 m_NumTilesX;
+    const Uint32 m_NumTilesY;
+
+    WorkerPool* const m_pWorkerPool;
+
+    float4x4              m_ViewProj;
+    std::vector<Occluder> m_Occluders;
+    // Index of the first triangle of every occluder, followed by the total number of triangles
+    std::vector<Uint32> m_OccluderTriangleOffsets;
+
+    std::vector<BinningContext> m_BinningContexts;
+
+    // Row-major NDC depth, cleared to FLT_MAX
+    std::vector<float> m_Depth;
+    // Farthest depth of every tile
+    std::vector<float> m_TileMaxDepth;
+};
+
+} // namespace Diligent
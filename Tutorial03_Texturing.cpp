@@ -1,267 +1,1513 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <tuple>
+
 #include "Tutorial03_Texturing.hpp"
 #include "MapHelper.hpp"
 #include "GraphicsUtilities.h"
 #include "TextureUtilities.h"
 #include "ColorConversion.h"
+#include "ShaderMacroHelper.hpp"
+#include "imgui.h"
 
 namespace Diligent
 {
 
+namespace
+{
+
+// Cube vertices
+
+//      (-1,+1,+1)________________(+1,+1,+1)
+//               /|              /|
+//              / |             / |
+//             /  |            /  |
+//            /   |           /   |
+//(-1,-1,+1) /____|__________/(+1,-1,+1)
+//           |    |__________|____|
+//           |   /(-1,+1,-1) |    /(+1,+1,-1)
+//           |  /            |   /
+//           | /             |  /
+//           |/              | /
+//           /_______________|/
+//        (-1,-1,-1)       (+1,-1,-1)
+//
+
+// This time we have to duplicate verices because texture coordinates cannot
+// be shared
+constexpr MeshVertex CubeVerts[] =
+    {
+        {float3{-1, -1, -1}, float2{0, 1}},
+        {float3{-1, +1, -1}, float2{0, 0}},
+        {float3{+1, +1, -1}, float2{1, 0}},
+        {float3{+1, -1, -1}, float2{1, 1}},
+
+        {float3{-1, -1, -1}, float2{0, 1}},
+        {float3{-1, -1, +1}, float2{0, 0}},
+        {float3{+1, -1, +1}, float2{1, 0}},
+        {float3{+1, -1, -1}, float2{1, 1}},
+
+        {float3{+1, -1, -1}, float2{0, 1}},
+        {float3{+1, -1, +1}, float2{1, 1}},
+        {float3{+1, +1, +1}, float2{1, 0}},
+        {float3{+1, +1, -1}, float2{0, 0}},
+
+        {float3{+1, +1, -1}, float2{0, 1}},
+        {float3{+1, +1, +1}, float2{0, 0}},
+        {float3{-1, +1, +1}, float2{1, 0}},
+        {float3{-1, +1, -1}, float2{1, 1}},
+
+        {float3{-1, +1, -1}, float2{1, 0}},
+        {float3{-1, +1, +1}, float2{0, 0}},
+        {float3{-1, -1, +1}, float2{0, 1}},
+        {float3{-1, -1, -1}, float2{1, 1}},
+
+        {float3{-1, -1, +1}, float2{1, 1}},
+        {float3{+1, -1, +1}, float2{0, 1}},
+        {float3{+1, +1, +1}, float2{0, 0}},
+        {float3{-1, +1, +1}, float2{1, 0}},
+};
+
+// clang-format off
+constexpr Uint32 CubeIndices[] =
+{
+    2,0,1,    2,3,0,
+    4,6,5,    4,7,6,
+    8,10,9,   8,11,10,
+    12,14,13, 12,15,14,
+    16,18,17, 16,19,18,
+    20,21,22, 20,22,23
+};
+// clang-format on
+
+const MeshData CubeMesh{CubeVerts, _countof(CubeVerts), CubeIndices, _countof(CubeIndices)};
+
+// Objects with at most this many vertices are streamed into the dynamic batch
+constexpr Uint32 MaxStreamedObjectVertices = 64;
+
+constexpr Uint32 DynamicBatchMaxVertices = 4096;
+constexpr Uint32 DynamicBatchMaxIndices  = 8192;
+
+constexpr float CameraNearPlane = 0.1f;
+constexpr float CameraFarPlane  = 100.f;
+
+// Number of the nearest visible objects rasterized as occluders by the software occlusion culler
+constexpr Uint32 MaxSoftwareOccluders = 32;
+
+// The node animations in ComputeNodeTransforms() turn at 1.0, 0.5 and 0.3 radians per second,
+// so all of them repeat after 20 * PI seconds (10, 5 and 3 turns).
+constexpr float  AnimationPeriod  = 20.f * PI_F;
+constexpr Uint32 AnimationSamples = 2048;
+
+// Seconds between the saves of the pipeline cache
+constexpr double PipelineCacheSavePeriod = 30.0;
+
+// Must be incremented when pipeline descriptions change in a way the shader sources do not
+// reflect, so that archives baked with the old descriptions are rejected.
+constexpr Uint32 PipelineArchiveVersion = 1;
+
+} // namespace
+
 SampleBase* CreateSample()
 {
     return new Tutorial03_Texturing();
 }
 
-void Tutorial03_Texturing::CreatePipelineState()
+bool Tutorial03_Texturing::ScenePipelines::IsReady() const
+{
+    for (IPipelineState* pPSO : {pColorPSO.RawPtr(), pDepthEqualPSO.RawPtr(), pDepthPrePassPSO.RawPtr()})
+    {
+        if (pPSO != nullptr && pPSO->GetStatus() != PIPELINE_STATE_STATUS_READY)
+            return false;
+    }
+    return true;
+}
+
+void Tutorial03_Texturing::ScenePipelines::WaitUntilReady() const
+{
+    for (IPipelineState* pPSO : {pColorPSO.RawPtr(), pDepthEqualPSO.RawPtr(), pDepthPrePassPSO.RawPtr()})
+    {
+        if (pPSO != nullptr)
+            pPSO->GetStatus(true);
+    }
+}
+
+Tutorial03_Texturing::~Tutorial03_Texturing()
+{
+    if (m_PipelineCache)
+        m_PipelineCache->Save();
+}
+
+SampleBase::CommandLineStatus Tutorial03_Texturing::ProcessCommandLine(int argc, const char* const* argv)
+{
+    // --bake_pipelines writes the pipeline archives of all backends during initialization
+    // --mesh <file.obj> adds instances of the mesh to the scene
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bake_pipelines") == 0)
+            m_BakePipelines = true;
+        else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc)
+            m_ImportedMeshPath = argv[++i];
+    }
+    return SampleBase::ProcessCommandLine(argc, argv);
+}
+
+void Tutorial03_Texturing::ModifyEngineInitInfo(const ModifyEngineInitInfoAttribs& Attribs)
 {
-    // Pipeline state object encompasses configuration of all GPU stages
+    SampleBase::ModifyEngineInitInfo(Attribs);
+
+    // Shaders and pipelines of the scene are compiled on the engine's thread pool
+    Attribs.EngineCI.Features.AsyncShaderCompilation = DEVICE_FEATURE_STATE_OPTIONAL;
+    // Feature switches of the shaders are applied when pipelines are created
+    Attribs.EngineCI.Features.SpecializationConstants = DEVICE_FEATURE_STATE_OPTIONAL;
+}
+
+void Tutorial03_Texturing::CreateMaterials()
+{
+    MaterialSystem::CreateInfo MaterialsCI;
+    MaterialsCI.pDevice               = m_pDevice;
+    MaterialsCI.SignatureBindingIndex = SIGNATURE_BINDING_MATERIAL;
+    m_Materials                       = std::make_unique<MaterialSystem>(MaterialsCI);
+
+    LoadTexture();
+
+    // All objects of the scene use the same material
+    MaterialSystem::MaterialDesc MaterialDesc;
+    MaterialDesc.pTexture = m_TextureSRV;
+    m_DefaultMaterial     = m_Materials->AddMaterial(MaterialDesc);
+}
+
+void Tutorial03_Texturing::CreateTransformSignature(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines)
+{
+    // All transform resources are static: they are bound once through the signature and
+    // copied into the SRB when it is created.
+    std::vector<PipelineResourceDesc> Resources;
+    switch (TransformSource)
+    {
+        case TRANSFORM_SOURCE_CONSTANTS:
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "Constants", 1, SHADER_RESOURCE_TYPE_CONSTANT_BUFFER, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            break;
+
+        case TRANSFORM_SOURCE_DRAW_TRANSFORMS:
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "DrawTransforms", 1, SHADER_RESOURCE_TYPE_CONSTANT_BUFFER, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            break;
+
+        case TRANSFORM_SOURCE_OBJECT_BUFFER:
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "SceneConstants", 1, SHADER_RESOURCE_TYPE_CONSTANT_BUFFER, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "g_Objects", 1, SHADER_RESOURCE_TYPE_BUFFER_SRV, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            break;
+
+        case TRANSFORM_SOURCE_ANIMATION_TEXTURE:
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "AnimationConstants", 1, SHADER_RESOURCE_TYPE_CONSTANT_BUFFER, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            Resources.emplace_back(SHADER_TYPE_VERTEX, "g_AnimationTexture", 1, SHADER_RESOURCE_TYPE_TEXTURE_SRV, SHADER_RESOURCE_VARIABLE_TYPE_STATIC);
+            break;
+    }
+    if (VertexPulling)
+    {
+        Resources.emplace_back(SHADER_TYPE_VERTEX, "g_Vertices", 1, SHADER_RESOURCE_TYPE_BUFFER_SRV, SHADER_RESOURCE_VARIABLE_TYPE_STATIC, PIPELINE_RESOURCE_FLAG_FORMATTED_BUFFER);
+        // The depth pre-pass pulls from the position stream only
+        Resources.emplace_back(SHADER_TYPE_VERTEX, "g_Positions", 1, SHADER_RESOURCE_TYPE_BUFFER_SRV, SHADER_RESOURCE_VARIABLE_TYPE_STATIC, PIPELINE_RESOURCE_FLAG_FORMATTED_BUFFER);
+    }
 
-    GraphicsPipelineStateCreateInfo PSOCreateInfo;
+    // The constant buffer of the constants path is rewritten before every draw, while the
+    // other sources change at most once per frame.
+    static constexpr const char* SignatureNames[] = {"Per-draw transform signature", "Per-frame transform signature (draw transforms)", "Per-frame transform signature (object buffer)", "Per-frame transform signature (animation texture)"};
 
-    // Pipeline state name is used by the engine to report issues.
-    // It is always a good idea to give objects descriptive names.
-    PSOCreateInfo.PSODesc.Name = "Cube PSO";
+    PipelineResourceSignatureDesc SignatureDesc;
+    SignatureDesc.Name         = VertexPulling ? "Per-frame transform signature (object buffer, vertex pulling)" : SignatureNames[TransformSource];
+    SignatureDesc.Resources    = Resources.data();
+    SignatureDesc.NumResources = static_cast<Uint32>(Resources.size());
+    SignatureDesc.BindingIndex = TransformSource == TRANSFORM_SOURCE_CONSTANTS ? SIGNATURE_BINDING_DRAW : SIGNATURE_BINDING_FRAME;
+    m_pDevice->CreatePipelineResourceSignature(SignatureDesc, &Pipelines.pTransformSignature);
 
-    // This is a graphics pipeline
-    PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_GRAPHICS;
+    IPipelineResourceSignature* pSignature = Pipelines.pTransformSignature;
+    switch (TransformSource)
+    {
+        case TRANSFORM_SOURCE_CONSTANTS:
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "Constants")->Set(m_VSConstants);
+            break;
+
+        case TRANSFORM_SOURCE_DRAW_TRANSFORMS:
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "DrawTransforms")->Set(m_DrawTransformsCB);
+            break;
+
+        case TRANSFORM_SOURCE_OBJECT_BUFFER:
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "SceneConstants")->Set(m_GPUScene->GetConstantsBuffer());
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "g_Objects")->Set(m_GPUScene->GetObjectsSRV());
+            break;
+
+        case TRANSFORM_SOURCE_ANIMATION_TEXTURE:
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "AnimationConstants")->Set(m_AnimationTexture->GetConstantsBuffer());
+            pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "g_AnimationTexture")->Set(m_AnimationTexture->GetSRV());
+            break;
+    }
+    if (VertexPulling)
+    {
+        pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "g_Vertices")->Set(m_GeometryPool->GetVertexBufferSRV());
+        pSignature->GetStaticVariableByName(SHADER_TYPE_VERTEX, "g_Positions")->Set(m_GeometryPool->GetPositionBufferSRV());
+    }
 
-    // clang-format off
-    // This tutorial will render to a single render target
-    PSOCreateInfo.GraphicsPipeline.NumRenderTargets             = 1;
-    // Set render target format which is the format of the swap chain's color buffer
-    PSOCreateInfo.GraphicsPipeline.RTVFormats[0]                = m_pSwapChain->GetDesc().ColorBufferFormat;
-    // Set depth buffer format which is the format of the swap chain's back buffer
-    PSOCreateInfo.GraphicsPipeline.DSVFormat                    = m_pSwapChain->GetDesc().DepthBufferFormat;
-    // Primitive topology defines what kind of primitives will be rendered by this pipeline state
-    PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    // Cull back faces
-    PSOCreateInfo.GraphicsPipeline.RasterizerDesc.CullMode      = CULL_MODE_BACK;
-    // Enable depth testing
-    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable = True;
-    // clang-format on
+    pSignature->CreateShaderResourceBinding(&Pipelines.pTransformSRB, true);
+}
 
-    ShaderCreateInfo ShaderCI;
-    // Tell the system that the shader source code is in HLSL.
-    // For OpenGL, the engine will convert this into GLSL under the hood.
-    ShaderCI.SourceLanguage = SHADER_SOURCE_LANGUAGE_HLSL;
+void Tutorial03_Texturing::CreatePipelineState(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines)
+{
+    // Pulled vertices are only read from the geometry pool, which the GPU-driven path draws from
+    VERIFY_EXPR(!VertexPulling || TransformSource == TRANSFORM_SOURCE_OBJECT_BUFFER);
 
-    // OpenGL backend requires emulated combined HLSL texture samplers (g_Texture + g_Texture_sampler combination)
-    ShaderCI.Desc.UseCombinedTextureSamplers = true;
+    // The depth pre-pass pipeline of the set uses the same transform signature
+    CreateTransformSignature(TransformSource, VertexPulling, Pipelines);
 
-    // Pack matrices in row-major order
-    ShaderCI.CompileFlags = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+    // The vertex shader does not depend on the material, so it is created on the first cache
+    // miss and shared by all pipelines of the set. Pixel shaders are created per material state
+    // and shared by its color and depth-equal pipelines. Cull mode does not affect them.
+    RefCntAutoPtr<IShader>                                                         pVS;
+    std::vector<std::pair<MaterialSystem::MaterialState, RefCntAutoPtr<IShader>>> PixelShaders;
 
     // Presentation engine always expects input in gamma space. Normally, pixel shader output is
     // converted from linear to gamma space by the GPU. However, some platforms (e.g. Android in GLES mode,
     // or Emscripten in WebGL mode) do not support gamma-correction. In this case the application
     // has to do the conversion manually.
-    ShaderMacro Macros[] = {{"CONVERT_PS_OUTPUT_TO_GAMMA", m_ConvertPSOutputToGamma ? "1" : "0"}};
-    ShaderCI.Macros      = {Macros, _countof(Macros)};
+    ShaderFeatures Features{m_UseSpecializationConstants};
+    Features.AddBool("ConvertPSOutputToGamma", SHADER_TYPE_PIXEL, m_ConvertPSOutputToGamma);
+
+    auto CreatePSO = [&](bool DepthEqual, const MaterialSystem::MaterialState& State, IPipelineState** ppPSO) {
+        // Pipeline state object encompasses configuration of all GPU stages
+
+        GraphicsPipelineStateCreateInfo PSOCreateInfo;
+
+        // Pipeline state name is used by the engine to report issues.
+        // It is always a good idea to give objects descriptive names.
+        static constexpr const char* PSONames[]           = {"Cube PSO", "Cube PSO (draw transforms)", "Cube PSO (object buffer)", "Cube PSO (animation texture)"};
+        static constexpr const char* DepthEqualPSONames[] = {"Cube PSO (depth equal)", "Cube PSO (draw transforms, depth equal)", "Cube PSO (object buffer, depth equal)", "Cube PSO (animation texture, depth equal)"};
+        if (DepthEqual)
+            PSOCreateInfo.PSODesc.Name = VertexPulling ? "Cube PSO (object buffer, vertex pulling, depth equal)" : DepthEqualPSONames[TransformSource];
+        else
+            PSOCreateInfo.PSODesc.Name = VertexPulling ? "Cube PSO (object buffer, vertex pulling)" : PSONames[TransformSource];
+
+        // Pipelines baked into the archive need no shader compilation
+        if (m_PipelineArchive->UnpackGraphicsPipeline(PSOCreateInfo.PSODesc.Name, ppPSO))
+            return;
+
+        // This is a graphics pipeline
+        PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_GRAPHICS;
+
+        // An asynchronous pipeline is compiled once its shaders are, without blocking this thread
+        if (m_AsyncCompilation)
+            PSOCreateInfo.Flags |= PSO_CREATE_FLAG_ASYNCHRONOUS;
+        PSOCreateInfo.pPSOCache = m_PipelineCache->GetCache();
+
+        // clang-format off
+        // This tutorial will render to a single render target
+        PSOCreateInfo.GraphicsPipeline.NumRenderTargets             = 1;
+        // Set render target format which is the format of the swap chain's color buffer
+        PSOCreateInfo.GraphicsPipeline.RTVFormats[0]                = m_pSwapChain->GetDesc().ColorBufferFormat;
+        // Set depth buffer format which is the format of the swap chain's back buffer
+        PSOCreateInfo.GraphicsPipeline.DSVFormat                    = m_pSwapChain->GetDesc().DepthBufferFormat;
+        // Primitive topology defines what kind of primitives will be rendered by this pipeline state
+        PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        // Cull mode is part of the material
+        PSOCreateInfo.GraphicsPipeline.RasterizerDesc.CullMode      = State.CullMode;
+        // Enable depth testing
+        PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable = True;
+        // clang-format on
+
+        // When depth is laid down by the pre-pass, the color pass only needs to shade the
+        // pixels that passed it. Depth writes are not needed since the buffer is already final.
+        if (DepthEqual)
+        {
+            PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthFunc        = COMPARISON_FUNC_EQUAL;
+            PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthWriteEnable = False;
+        }
+
+        auto CreateShader = [&](SHADER_TYPE ShaderType, const char* Name, const char* FilePath, const MaterialSystem::MaterialState* pState, IShader** ppShader) {
+            ShaderCreateInfo ShaderCI;
+            // Tell the system that the shader source code is in HLSL.
+            // For OpenGL, the engine will convert this into GLSL under the hood.
+            ShaderCI.SourceLanguage = SHADER_SOURCE_LANGUAGE_HLSL;
+
+            // OpenGL backend requires emulated combined HLSL texture samplers (g_Texture + g_Texture_sampler combination)
+            ShaderCI.Desc.UseCombinedTextureSamplers = true;
+
+            // Pack matrices in row-major order
+            ShaderCI.CompileFlags = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+            if (m_AsyncCompilation)
+                ShaderCI.CompileFlags |= SHADER_COMPILE_FLAG_ASYNCHRONOUS;
+
+            // When USE_DRAW_TRANSFORMS is set, the vertex shader reads the matrix for the current
+            // draw from an array indexed by the per-instance draw id attribute.
+            // When USE_OBJECT_BUFFER is set, the draw id indexes the GPU scene object records instead.
+            // When USE_ANIMATION_TEXTURE is set, the draw id is the track of the object in the animation texture.
+            // When VERTEX_PULLING is set, vertices are read from the geometry pool by the vertex id,
+            // laid out as described by the object record.
+            ShaderMacroHelper Macros;
+            Features.AddShaderMacros(Macros);
+            Macros.AddShaderMacro("USE_DRAW_TRANSFORMS", TransformSource == TRANSFORM_SOURCE_DRAW_TRANSFORMS ? 1 : 0);
+            Macros.AddShaderMacro("USE_OBJECT_BUFFER", TransformSource == TRANSFORM_SOURCE_OBJECT_BUFFER ? 1 : 0);
+            Macros.AddShaderMacro("USE_ANIMATION_TEXTURE", TransformSource == TRANSFORM_SOURCE_ANIMATION_TEXTURE ? 1 : 0);
+            Macros.AddShaderMacro("MAX_DRAW_TRANSFORMS", static_cast<Uint32>(MaxBundleDraws));
+            Macros.AddShaderMacro("VERTEX_PULLING", VertexPulling ? 1 : 0);
+            // Material macros only affect the pixel shader
+            if (pState != nullptr)
+            {
+                for (const auto& Macro : pState->Macros)
+                    Macros.AddShaderMacro(Macro.first.c_str(), Macro.second.c_str());
+            }
+            ShaderCI.Macros = Macros;
+
+            // Create a shader source stream factory to load shaders from files.
+            RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderSourceFactory;
+            m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderSourceFactory);
+            ShaderCI.pShaderSourceStreamFactory = pShaderSourceFactory;
+
+            ShaderCI.Desc.ShaderType = ShaderType;
+            ShaderCI.EntryPoint      = "main";
+            ShaderCI.Desc.Name       = Name;
+            ShaderCI.FilePath        = FilePath;
+            m_PipelineArchive->CreateShader(ShaderCI, ppShader);
+        };
 
-    // Create a shader source stream factory to load shaders from files.
-    RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderSourceFactory;
-    m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderSourceFactory);
-    ShaderCI.pShaderSourceStreamFactory = pShaderSourceFactory;
-    // Create a vertex shader
+        // Create a vertex shader
+        if (!pVS)
+            CreateShader(SHADER_TYPE_VERTEX, "Cube VS", "cube.vsh", nullptr, &pVS);
+
+        // Create a pixel shader, unless a state that only differs in cull mode already has one
+        auto PSIt = std::find_if(PixelShaders.begin(), PixelShaders.end(), [&](const auto& PS) {
+            return PS.first.PSFilePath == State.PSFilePath && PS.first.Macros == State.Macros;
+        });
+        if (PSIt == PixelShaders.end())
+        {
+            RefCntAutoPtr<IShader> pPS;
+            CreateShader(SHADER_TYPE_PIXEL, "Cube PS", State.PSFilePath.c_str(), &State, &pPS);
+            PSIt = PixelShaders.emplace(PixelShaders.end(), State, std::move(pPS));
+        }
+
+        // clang-format off
+        // Define vertex shader input layout
+        LayoutElement LayoutElems[] =
+        {
+            // Attribute 0 - vertex position
+            LayoutElement{0, 0, 3, VT_FLOAT32, False},
+            // Attribute 1 - texture coordinates
+            LayoutElement{1, 0, 2, VT_FLOAT32, False},
+            // Attribute 2 - draw id, one per instance
+            LayoutElement{2, 1, 1, VT_UINT32, False, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}
+        };
+        // With vertex pulling, the draw id is the only attribute and its buffer is the only one bound.
+        // SV_InstanceID does not include FirstInstanceLocation in D3D, so the attribute is still needed.
+        LayoutElement PulledLayoutElems[] =
+        {
+            // Attribute 2 - draw id, one per instance
+            LayoutElement{2, 0, 1, VT_UINT32, False, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}
+        };
+        // clang-format on
+
+        PSOCreateInfo.pVS = pVS;
+        PSOCreateInfo.pPS = PSIt->second;
+        Features.SetSpecializationConstants(PSOCreateInfo);
+
+        if (VertexPulling)
+        {
+            PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = PulledLayoutElems;
+            PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = _countof(PulledLayoutElems);
+        }
+        else
+        {
+            PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = LayoutElems;
+            PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = TransformSource != TRANSFORM_SOURCE_CONSTANTS ? 3 : 2;
+        }
+
+        // Resources are defined by the signatures rather than by the resource layout of the pipeline.
+        // Every signature has its own binding index, so resources committed for one of them stay
+        // bound when the pipeline changes, as long as the new pipeline uses the same signature.
+        IPipelineResourceSignature* ppSignatures[] = {Pipelines.pTransformSignature, m_Materials->GetSignature()};
+        PSOCreateInfo.ppResourceSignatures          = ppSignatures;
+        PSOCreateInfo.ResourceSignaturesCount       = _countof(ppSignatures);
+
+        m_PipelineArchive->CreateGraphicsPipeline(PSOCreateInfo, ppPSO);
+    };
+
+    // Pipelines come from the material system, so pipelines of materials with the same state
+    // are only created once.
+    for (bool DepthEqual : {false, true})
+    {
+        const Uint32    Variant = GetPipelineVariant(TransformSource, VertexPulling, DepthEqual);
+        IPipelineState* pPSO    = m_Materials->PreparePipeline(m_DefaultMaterial, Variant, [&](const MaterialSystem::MaterialState& State, IPipelineState** ppPSO) {
+            CreatePSO(DepthEqual, State, ppPSO);
+        });
+        (DepthEqual ? Pipelines.pDepthEqualPSO : Pipelines.pColorPSO) = pPSO;
+    }
+    // Both pipelines use the same signatures, so the same SRBs serve both of them
+    VERIFY_EXPR(Pipelines.pColorPSO->IsCompatibleWith(Pipelines.pDepthEqualPSO));
+}
+
+void Tutorial03_Texturing::CreateDepthPrePassPipelineState(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines)
+{
+    VERIFY_EXPR(!VertexPulling || TransformSource == TRANSFORM_SOURCE_OBJECT_BUFFER);
+    // Animated objects are drawn after the other passes with the regular depth test
+    VERIFY_EXPR(TransformSource != TRANSFORM_SOURCE_ANIMATION_TEXTURE);
+    VERIFY(Pipelines.pTransformSignature, "The transform signature is created with the color pipelines");
+
+    // Only the vertex shader is needed: the pass writes depth and nothing else.
+    // It does not depend on the material and is created on the first cache miss.
     RefCntAutoPtr<IShader> pVS;
+
+    auto CreatePSO = [&](const MaterialSystem::MaterialState& State, IPipelineState** ppPSO) {
+        GraphicsPipelineStateCreateInfo PSOCreateInfo;
+
+        static constexpr const char* PSONames[] = {"Cube depth pre-pass PSO", "Cube depth pre-pass PSO (draw transforms)", "Cube depth pre-pass PSO (object buffer)"};
+        PSOCreateInfo.PSODesc.Name         = VertexPulling ? "Cube depth pre-pass PSO (object buffer, vertex pulling)" : PSONames[TransformSource];
+        PSOCreateInfo.PSODesc.PipelineType = PIPELINE_TYPE_GRAPHICS;
+        if (m_PipelineArchive->UnpackGraphicsPipeline(PSOCreateInfo.PSODesc.Name, ppPSO))
+            return;
+        if (m_AsyncCompilation)
+            PSOCreateInfo.Flags |= PSO_CREATE_FLAG_ASYNCHRONOUS;
+        PSOCreateInfo.pPSOCache = m_PipelineCache->GetCache();
+
+        // clang-format off
+        // Depth pre-pass does not write any color, so no render targets are needed
+        PSOCreateInfo.GraphicsPipeline.NumRenderTargets             = 0;
+        PSOCreateInfo.GraphicsPipeline.DSVFormat                    = m_pSwapChain->GetDesc().DepthBufferFormat;
+        PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        // Must match the color pass, or the EQUAL depth test rejects the faces culled here
+        PSOCreateInfo.GraphicsPipeline.RasterizerDesc.CullMode      = State.CullMode;
+        PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable = True;
+        // clang-format on
+
+        // The shader must transform positions exactly like cube.vsh does, otherwise
+        // the EQUAL depth test in the color pass will reject pixels.
+        if (!pVS)
+        {
+            ShaderCreateInfo ShaderCI;
+            ShaderCI.SourceLanguage = SHADER_SOURCE_LANGUAGE_HLSL;
+            ShaderCI.CompileFlags   = SHADER_COMPILE_FLAG_PACK_MATRIX_ROW_MAJOR;
+            if (m_AsyncCompilation)
+                ShaderCI.CompileFlags |= SHADER_COMPILE_FLAG_ASYNCHRONOUS;
+
+            ShaderMacroHelper Macros;
+            Macros.AddShaderMacro("USE_DRAW_TRANSFORMS", TransformSource == TRANSFORM_SOURCE_DRAW_TRANSFORMS ? 1 : 0);
+            Macros.AddShaderMacro("USE_OBJECT_BUFFER", TransformSource == TRANSFORM_SOURCE_OBJECT_BUFFER ? 1 : 0);
+            Macros.AddShaderMacro("MAX_DRAW_TRANSFORMS", static_cast<Uint32>(MaxBundleDraws));
+            Macros.AddShaderMacro("VERTEX_PULLING", VertexPulling ? 1 : 0);
+            ShaderCI.Macros = Macros;
+
+            RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderSourceFactory;
+            m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderSourceFactory);
+            ShaderCI.pShaderSourceStreamFactory = pShaderSourceFactory;
+
+            ShaderCI.Desc.ShaderType = SHADER_TYPE_VERTEX;
+            ShaderCI.EntryPoint      = "main";
+            ShaderCI.Desc.Name       = "Cube depth VS";
+            ShaderCI.FilePath        = "cube_depth.vsh";
+            m_PipelineArchive->CreateShader(ShaderCI, &pVS);
+        }
+
+        // clang-format off
+        // The pass reads positions only, from the tightly packed position stream of the
+        // geometry pool and the dynamic batch rather than from the interleaved vertices.
+        LayoutElement LayoutElems[] =
+        {
+            // Attribute 0 - vertex position
+            LayoutElement{0, 0, 3, VT_FLOAT32, False},
+            // Attribute 2 - draw id, one per instance
+            LayoutElement{2, 1, 1, VT_UINT32, False, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}
+        };
+        LayoutElement PulledLayoutElems[] =
+        {
+            // Attribute 2 - draw id, one per instance
+            LayoutElement{2, 0, 1, VT_UINT32, False, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}
+        };
+        // clang-format on
+
+        PSOCreateInfo.pVS = pVS;
+
+        if (VertexPulling)
+        {
+            PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = PulledLayoutElems;
+            PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = _countof(PulledLayoutElems);
+        }
+        else
+        {
+            PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = LayoutElems;
+            PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = TransformSource != TRANSFORM_SOURCE_CONSTANTS ? 2 : 1;
+        }
+
+        // The pass reads no material resources, so it only uses the transform signature. Its
+        // binding index matches the color pipelines, so the transform SRB stays bound when the
+        // color pass follows.
+        IPipelineResourceSignature* ppSignatures[] = {Pipelines.pTransformSignature};
+        PSOCreateInfo.ppResourceSignatures          = ppSignatures;
+        PSOCreateInfo.ResourceSignaturesCount       = _countof(ppSignatures);
+
+        m_PipelineArchive->CreateGraphicsPipeline(PSOCreateInfo, ppPSO);
+    };
+
+    // The pipeline comes from the material system like the color pipelines, so its
+    // cull mode follows the material state that the depth-equal pass is drawn with.
+    Pipelines.pDepthPrePassPSO = m_Materials->PreparePipeline(m_DefaultMaterial, GetDepthPrePassVariant(TransformSource, VertexPulling), CreatePSO);
+}
+
+void Tutorial03_Texturing::CreateMeshes()
+{
+    GeometryPool::CreateInfo PoolCI;
+    PoolCI.pDevice                = m_pDevice;
+    PoolCI.BaseVertexSupported    = (m_pDevice->GetAdapterInfo().DrawCommand.CapFlags & DRAW_COMMAND_CAP_FLAG_BASE_VERTEX) != 0;
+    // Only the GPU-driven path pulls vertices
+    PoolCI.ShaderResourceVertices = GPUScene::IsSupported(m_pDevice);
+    // Depth pre-pass pipelines bind or pull positions only
+    PoolCI.PositionStream         = true;
+    m_GeometryPool                = std::make_unique<GeometryPool>(PoolCI);
+
+    // Meshes loaded with LoadOBJ() go through the same steps as the cube.
+    // Returns the index of the mesh, or ~0u if it does not fit in the pool.
+    auto AddMesh = [&](MeshBuffers&& Mesh) {
+        OptimizeMesh(Mesh);
+
+        const GeometryPool::MeshHandle Handle = m_GeometryPool->Allocate(m_pImmediateContext, Mesh.GetData());
+        if (Handle.NumIndices == 0)
+            return ~0u;
+
+        m_MeshBuffers.emplace_back(std::move(Mesh));
+        const MeshData Data = m_MeshBuffers.back().GetData();
+        m_Meshes.push_back(Handle);
+        m_MeshBounds.push_back(ComputeBoundingSphere(Data));
+        m_MeshData.push_back(Data);
+        return static_cast<Uint32>(m_Meshes.size() - 1);
+    };
+
+    // Mesh 0 - cube
+    AddMesh(MeshBuffers{CubeMesh});
+
+    // Mesh 1 - the mesh given on the command line, if any
+    if (!m_ImportedMeshPath.empty())
     {
-        ShaderCI.Desc.ShaderType = SHADER_TYPE_VERTEX;
-        ShaderCI.EntryPoint      = "main";
-        ShaderCI.Desc.Name       = "Cube VS";
-        ShaderCI.FilePath        = "cube.vsh";
-        m_pDevice->CreateShader(ShaderCI, &pVS);
-        // Create dynamic uniform buffer that will store our transformation matrix
-        // Dynamic buffers can be frequently updated by the CPU
-        CreateUniformBuffer(m_pDevice, sizeof(float4x4), "VS constants CB", &m_VSConstants);
+        MeshBuffers ImportedMesh;
+        if (LoadOBJ(m_ImportedMeshPath.c_str(), ImportedMesh))
+            m_ImportedMesh = AddMesh(std::move(ImportedMesh));
     }
+}
+
+void Tutorial03_Texturing::CreateDrawIdBuffer()
+{
+    // Draw N of a command bundle uses FirstInstanceLocation = N, so the per-instance
+    // attribute fetched from this buffer is the index of the draw's transform.
+    // Indirect draws of the GPU scene use it the same way to find their object.
+    std::vector<Uint32> DrawIds(std::max(MaxBundleDraws, MaxGPUSceneObjects));
+    for (Uint32 i = 0; i < DrawIds.size(); ++i)
+        DrawIds[i] = i;
+
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name      = "Draw id buffer";
+    VertBuffDesc.Usage     = USAGE_IMMUTABLE;
+    VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
+    VertBuffDesc.Size      = DrawIds.size() * sizeof(DrawIds[0]);
+    BufferData VBData;
+    VBData.pData    = DrawIds.data();
+    VBData.DataSize = VertBuffDesc.Size;
+    m_pDevice->CreateBuffer(VertBuffDesc, &VBData, &m_DrawIdBuffer);
+}
+
+void Tutorial03_Texturing::LoadTexture()
+{
+    TextureLoadInfo loadInfo;
+    loadInfo.IsSRGB = true;
+    RefCntAutoPtr<ITexture> Tex;
+    CreateTextureFromFile("DGLogo.png", loadInfo, m_pDevice, &Tex);
+    // Get shader resource view from the texture
+    m_TextureSRV = Tex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+}
+
+
+void Tutorial03_Texturing::Initialize(const SampleInitInfo& InitInfo)
+{
+    SampleBase::Initialize(InitInfo);
+
+    // Pipeline creation only enqueues the compilation, and the engine runs the shaders
+    // of a pipeline before the pipeline itself. Initialization continues while they compile.
+    m_AsyncCompilation = m_pDevice->GetDeviceInfo().Features.AsyncShaderCompilation == DEVICE_FEATURE_STATE_ENABLED;
+    // Baked shaders are serialized for all backends, and only Vulkan has specialization constants
+    m_UseSpecializationConstants = ShaderFeatures::SpecializationConstantsSupported(m_pDevice) && !m_BakePipelines;
+
+    // Create dynamic uniform buffer that will store our transformation matrix
+    // Dynamic buffers can be frequently updated by the CPU
+    CreateUniformBuffer(m_pDevice, sizeof(float4x4), "VS constants CB", &m_VSConstants);
+    // Transforms of all draws recorded in a command bundle, updated once per frame
+    CreateUniformBuffer(m_pDevice, sizeof(float4x4) * MaxBundleDraws, "Draw transforms CB", &m_DrawTransformsCB);
+
+    RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderSourceFactory;
+    m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderSourceFactory);
 
-    // Create a pixel shader
-    RefCntAutoPtr<IShader> pPS;
+    // Scene pipelines are unpacked from the archive when it was baked from the same shader
+    // sources. Macros that do not come from the files are covered by the salt.
+    const Uint32 ArchiveSalt = (PipelineArchiveVersion * 31u + MaxBundleDraws) * 31u + (m_ConvertPSOutputToGamma ? 1u : 0u);
+
+    PipelineArchive::CreateInfo ArchiveCI;
+    ArchiveCI.pEngineFactory = m_pEngineFactory;
+    ArchiveCI.pDevice        = m_pDevice;
+    ArchiveCI.FilePrefix     = "Tutorial03_Texturing_pipelines";
+    ArchiveCI.ContentVersion = PipelineArchive::ComputeContentVersion(pShaderSourceFactory, {"cube.vsh", "cube.psh", "cube_depth.vsh", "gpu_scene.fxh", "animation_texture.fxh", "shader_features.fxh"}, ArchiveSalt);
+
+    // All pipelines are created through the cache, so later runs skip driver compilation and,
+    // on OpenGL, program linking. Any shader change resets the cache, which would otherwise
+    // keep the program binaries of the old shaders.
+    PersistentPipelineCache::CreateInfo CacheCI;
+    CacheCI.pDevice        = m_pDevice;
+    CacheCI.FilePath       = "Tutorial03_Texturing_pipeline_cache.bin";
+    CacheCI.ContentVersion = PipelineArchive::ComputeContentVersion(pShaderSourceFactory, {"debug_draw.vsh", "debug_draw.psh", "occlusion_box.vsh", "gpu_animation.csh", "gpu_draw_args.csh", "gpu_scene_scatter.csh", "hiz_downsample.csh"}, ArchiveCI.ContentVersion);
+    m_PipelineCache        = std::make_unique<PersistentPipelineCache>(CacheCI);
+
+    // Scene shaders baked into the Vulkan archive are optimized and stripped of unused resources.
+    // Shaders compiled from source at run time are used as they are.
+    if (m_BakePipelines && ShaderOptimizer::IsSupported(m_pDevice))
     {
-        ShaderCI.Desc.ShaderType = SHADER_TYPE_PIXEL;
-        ShaderCI.EntryPoint      = "main";
-        ShaderCI.Desc.Name       = "Cube PS";
-        ShaderCI.FilePath        = "cube.psh";
-        m_pDevice->CreateShader(ShaderCI, &pPS);
+        ShaderOptimizer::CreateInfo OptimizerCI;
+        OptimizerCI.pDevice = m_pDevice;
+        m_ShaderOptimizer   = std::make_unique<ShaderOptimizer>(OptimizerCI);
     }
 
-    // clang-format off
-    // Define vertex shader input layout
-    LayoutElement LayoutElems[] =
+    ArchiveCI.pPSOCache        = m_PipelineCache->GetCache();
+    ArchiveCI.pShaderOptimizer = m_ShaderOptimizer.get();
+    ArchiveCI.Bake             = m_BakePipelines;
+    m_PipelineArchive          = std::make_unique<PipelineArchive>(ArchiveCI);
+
+    // Pipelines that pull vertices bind the geometry pool buffers, so meshes are created first
+    CreateMeshes();
+    CreateMaterials();
+    CreatePipelineState(TRANSFORM_SOURCE_CONSTANTS, false, m_Pipelines);
+    CreateDepthPrePassPipelineState(TRANSFORM_SOURCE_CONSTANTS, false, m_Pipelines);
+    CreatePipelineState(TRANSFORM_SOURCE_DRAW_TRANSFORMS, false, m_BundlePipelines);
+    CreateDepthPrePassPipelineState(TRANSFORM_SOURCE_DRAW_TRANSFORMS, false, m_BundlePipelines);
+    CreateGPUScene(pShaderSourceFactory);
+    CreateDrawIdBuffer();
+
+    // Draw ids are fetched as per-instance attributes starting at FirstInstanceLocation,
+    // which GLES does not support.
+    m_CommandBundlesSupported = m_pDevice->GetDeviceInfo().Type != RENDER_DEVICE_TYPE_GLES;
+
+    CreateScene();
+    CreateBatches();
+    CreateAnimationTexture();
+
+    DebugDraw::CreateInfo DebugDrawCI;
+    DebugDrawCI.pDevice                    = m_pDevice;
+    DebugDrawCI.pShaderSourceFactory       = pShaderSourceFactory;
+    DebugDrawCI.pPSOCache                  = m_PipelineCache->GetCache();
+    DebugDrawCI.UseSpecializationConstants = m_UseSpecializationConstants;
+    DebugDrawCI.RTVFormat                  = m_pSwapChain->GetDesc().ColorBufferFormat;
+    DebugDrawCI.DSVFormat                  = m_pSwapChain->GetDesc().DepthBufferFormat;
+    DebugDrawCI.ConvertPSOutputToGamma     = m_ConvertPSOutputToGamma;
+    m_DebugDraw                            = std::make_unique<DebugDraw>(DebugDrawCI);
+
+    // The render thread takes part in every parallel loop, so one worker fewer than cores is started
+    m_WorkerPool = std::make_unique<WorkerPool>(std::max(std::thread::hardware_concurrency(), 1u) - 1u);
+
+    SoftwareOcclusionCuller::CreateInfo SoftwareOcclusionCI;
+    SoftwareOcclusionCI.pWorkerPool = m_WorkerPool.get();
+    m_SoftwareOcclusion             = std::make_unique<SoftwareOcclusionCuller>(SoftwareOcclusionCI);
+
+    if (OcclusionQueries::IsSupported(m_pDevice))
     {
-        // Attribute 0 - vertex position
-        LayoutElement{0, 0, 3, VT_FLOAT32, False},
-        // Attribute 1 - texture coordinates
-        LayoutElement{1, 0, 2, VT_FLOAT32, False}
+        OcclusionQueries::CreateInfo QueriesCI;
+        QueriesCI.pDevice              = m_pDevice;
+        QueriesCI.pShaderSourceFactory = pShaderSourceFactory;
+        QueriesCI.pPSOCache            = m_PipelineCache->GetCache();
+        QueriesCI.RTVFormat            = m_pSwapChain->GetDesc().ColorBufferFormat;
+        QueriesCI.DSVFormat            = m_pSwapChain->GetDesc().DepthBufferFormat;
+        m_OcclusionQueries             = std::make_unique<OcclusionQueries>(QueriesCI);
+    }
+
+    // All scene pipelines have been created, so the baked archives are complete
+    if (m_PipelineArchive->IsBaking())
+        m_PipelineArchive->Save();
+
+    // The first frame only needs the draw-item pipelines. Other paths are
+    // used once their pipelines are ready.
+    m_Pipelines.WaitUntilReady();
+}
+
+void Tutorial03_Texturing::CreateScene()
+{
+    m_NodeTransforms.resize(SCENE_NODE_COUNT);
+
+    auto AddCube = [this](SCENE_NODE Node, const float4x4& LocalTransform) {
+        SceneObject Obj;
+        Obj.Node           = Node;
+        Obj.LocalTransform = LocalTransform;
+        m_Objects.push_back(Obj);
     };
-    // clang-format on
 
-    PSOCreateInfo.pVS = pVS;
-    PSOCreateInfo.pPS = pPS;
+    // Cubos 2, 3, 4 y 5 y las líneas usan la misma rotación que el cubo central
+    // y nunca se mueven respecto a él.
+    AddCube(SCENE_NODE_CUBE1, float4x4::Identity());                    // Cubo central
+    AddCube(SCENE_NODE_CUBE1, float4x4::Translation(3.0f, 0.0f, 0.0f));   // Cubo derecho
+    AddCube(SCENE_NODE_CUBE1, float4x4::Translation(-3.0f, 0.0f, 0.0f));  // Cubo izquierdo
+    AddCube(SCENE_NODE_CUBE1, float4x4::Translation(3.0f, -3.0f, 0.0f));  // Cubo debajo del derecho
+    AddCube(SCENE_NODE_CUBE1, float4x4::Translation(-3.0f, -4.0f, 0.0f)); // Cubo debajo del izquierdo
+    AddCube(SCENE_NODE_CUBE6, float4x4::Identity());                    // Cubo a la derecha del cubo 4 (órbita + rotación propia)
+    AddCube(SCENE_NODE_CUBE7, float4x4::Identity());                    // Cubo a la izquierda del cubo 4 (órbita + rotación propia)
+    AddCube(SCENE_NODE_CUBE8, float4x4::Identity());                    // Cubo arriba del cubo central
+
+    // Connecting lines are drawn by the debug renderer. The end points match the
+    // extents of the scaled cubes that were used for them before.
+    m_SceneLines.push_back({SCENE_NODE_CUBE1, float3{0, 0, 0}, float3{0, 4, 0}});    // Línea entre el cubo central y el cubo 8
+    m_SceneLines.push_back({SCENE_NODE_CUBE1, float3{-4, 0, 0}, float3{4, 0, 0}});   // Línea entre el cubo 2 y el cubo 3
+    m_SceneLines.push_back({SCENE_NODE_CUBE1, float3{3, 0, 0}, float3{3, -4, 0}});   // Línea entre el cubo 2 y el cubo 4
+    m_SceneLines.push_back({SCENE_NODE_CUBE1, float3{-3, 0, 0}, float3{-3, -4, 0}}); // Línea entre el cubo 3 y el cubo 5
+
+    if (m_ImportedMesh != ~0u)
+    {
+        // The imported mesh is centered and scaled to the size of a cube, whatever its units
+        const BoundingSphere& Bounds    = m_MeshBounds[m_ImportedMesh];
+        const float           Scale     = std::sqrt(3.0f) / std::max(Bounds.Radius, 1e-6f);
+        const float4x4        Normalize = float4x4::Translation(-Bounds.Center.x, -Bounds.Center.y, -Bounds.Center.z) * float4x4::Scale(Scale, Scale, Scale);
+
+        auto AddImported = [&](SCENE_NODE Node, const float4x4& LocalTransform) {
+            SceneObject Obj;
+            Obj.Node           = Node;
+            Obj.Mesh           = m_ImportedMesh;
+            Obj.LocalTransform = Normalize * LocalTransform;
+            m_Objects.push_back(Obj);
+        };
+        AddImported(SCENE_NODE_CUBE1, float4x4::Translation(0.0f, -4.0f, 0.0f)); // Debajo del cubo central
+        AddImported(SCENE_NODE_CUBE1, float4x4::Translation(0.0f, 0.0f, 3.0f));  // Detrás del cubo central
+    }
 
-    PSOCreateInfo.GraphicsPipeline.InputLayout.LayoutElements = LayoutElems;
-    PSOCreateInfo.GraphicsPipeline.InputLayout.NumElements    = _countof(LayoutElems);
+    m_NumSceneObjects = m_Objects.size();
+    UpdateNodeObjects();
+}
 
-    // Define variable type that will be used by default
-    PSOCreateInfo.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+void Tutorial03_Texturing::UpdateNodeObjects()
+{
+    m_NodeObjects.assign(SCENE_NODE_COUNT, {});
+    for (Uint32 i = 0; i < m_Objects.size(); ++i)
+        m_NodeObjects[m_Objects[i].Node].push_back(i);
+
+    m_UpdateAllObjects       = true;
+    m_RebuildGPUSceneObjects = true;
+}
 
-    // clang-format off
-    // Shader variables should typically be mutable, which means they are expected
-    // to change on a per-instance basis
-    ShaderResourceVariableDesc Vars[] = 
+void Tutorial03_Texturing::CreateBatches()
+{
+    // Group objects that share a scene node, a mesh and a material
+    std::map<std::tuple<Uint32, Uint32, Uint32>, std::vector<Uint32>> Groups;
+    for (Uint32 i = 0; i < m_Objects.size(); ++i)
     {
-        {SHADER_TYPE_PIXEL, "g_Texture", SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE}
-    };
-    // clang-format on
-    PSOCreateInfo.PSODesc.ResourceLayout.Variables    = Vars;
-    PSOCreateInfo.PSODesc.ResourceLayout.NumVariables = _countof(Vars);
+        const SceneObject& Obj = m_Objects[i];
+        Groups[std::make_tuple(Obj.Node, Obj.Mesh, Obj.Material)].push_back(i);
+    }
 
-    // clang-format off
-    // Define immutable sampler for g_Texture. Immutable samplers should be used whenever possible
-    SamplerDesc SamLinearClampDesc
+    for (const auto& Group : Groups)
     {
-        FILTER_TYPE_LINEAR, FILTER_TYPE_LINEAR, FILTER_TYPE_LINEAR, 
-        TEXTURE_ADDRESS_CLAMP, TEXTURE_ADDRESS_CLAMP, TEXTURE_ADDRESS_CLAMP
-    };
-    ImmutableSamplerDesc ImtblSamplers[] = 
+        const std::vector<Uint32>& ObjIds = Group.second;
+        if (ObjIds.size() < 2)
+        {
+            // Nothing to merge with. Small objects are streamed instead.
+            SceneObject& Obj = m_Objects[ObjIds[0]];
+            Obj.Streamed     = m_MeshData[Obj.Mesh].NumVertices <= MaxStreamedObjectVertices;
+            continue;
+        }
+
+        std::vector<StaticBatch::Instance> Instances;
+        Instances.reserve(ObjIds.size());
+        for (Uint32 ObjId : ObjIds)
+        {
+            m_Objects[ObjId].Batched = true;
+            m_Objects[ObjId].BatchId = static_cast<Uint32>(m_StaticBatches.size());
+            Instances.push_back({m_Objects[ObjId].LocalTransform});
+        }
+
+        SceneBatch Batch;
+        Batch.Node   = std::get<0>(Group.first);
+        Batch.pBatch = std::make_unique<StaticBatch>(*m_GeometryPool, m_pImmediateContext, m_MeshData[std::get<1>(Group.first)], Instances.data(), static_cast<Uint32>(Instances.size()));
+        m_StaticBatches.emplace_back(std::move(Batch));
+    }
+
+    m_DynamicBatch = std::make_unique<DynamicBatch>(m_pDevice, "Dynamic batch", DynamicBatchMaxVertices, DynamicBatchMaxIndices, true);
+}
+
+void Tutorial03_Texturing::GenerateObjects(Uint32 NumObjects)
+{
+    // Generated objects are created after the batches and are always drawn individually
+    m_Objects.resize(m_NumSceneObjects);
+
+    // Square grid below the scene that starts at its depth and extends away from the camera
+    constexpr float Spacing  = 3.0f;
+    const Uint32    GridSize = static_cast<Uint32>(std::ceil(std::sqrt(static_cast<float>(NumObjects))));
+    for (Uint32 i = 0; i < NumObjects; ++i)
     {
-        {SHADER_TYPE_PIXEL, "g_Texture", SamLinearClampDesc}
+        const float X = (static_cast<float>(i % GridSize) - static_cast<float>(GridSize - 1) * 0.5f) * Spacing;
+        const float Z = static_cast<float>(i / GridSize) * Spacing;
+
+        SceneObject Obj;
+        Obj.Node           = SCENE_NODE_GRID;
+        Obj.LocalTransform = float4x4::Translation(X, -8.0f, Z);
+        m_Objects.push_back(Obj);
+    }
+    UpdateNodeObjects();
+    m_GPUAnimationDirty = true;
+}
+
+void Tutorial03_Texturing::CreateGPUScene(IShaderSourceInputStreamFactory* pShaderSourceFactory)
+{
+    if (!GPUScene::IsSupported(m_pDevice))
+        return;
+
+    GPUScene::CreateInfo GPUSceneCI;
+    GPUSceneCI.pDevice              = m_pDevice;
+    GPUSceneCI.pShaderSourceFactory = pShaderSourceFactory;
+    GPUSceneCI.pPSOCache            = m_PipelineCache->GetCache();
+    GPUSceneCI.MaxObjects           = MaxGPUSceneObjects;
+    m_GPUScene                      = std::make_unique<GPUScene>(GPUSceneCI);
+
+    // The GPU-driven path always pulls vertices: the vertex format is read from the object
+    // records, so one pipeline draws meshes of every format in the geometry pool.
+    CreatePipelineState(TRANSFORM_SOURCE_OBJECT_BUFFER, true, m_GPUScenePipelines);
+    CreateDepthPrePassPipelineState(TRANSFORM_SOURCE_OBJECT_BUFFER, true, m_GPUScenePipelines);
+
+    GPUAnimation::CreateInfo AnimationCI;
+    AnimationCI.pDevice              = m_pDevice;
+    AnimationCI.pShaderSourceFactory = pShaderSourceFactory;
+    AnimationCI.pPSOCache            = m_PipelineCache->GetCache();
+    AnimationCI.pObjectsUAV          = m_GPUScene->GetObjectsUAV();
+    AnimationCI.MaxObjects           = MaxGPUSceneObjects;
+    m_GPUAnimation                   = std::make_unique<GPUAnimation>(AnimationCI);
+
+    // The swap chain depth buffer cannot be read by shaders, so occlusion culling renders
+    // the scene into a depth buffer of the same format owned by the pyramid.
+    HiZPyramid::CreateInfo HiZCI;
+    HiZCI.pDevice              = m_pDevice;
+    HiZCI.pShaderSourceFactory = pShaderSourceFactory;
+    HiZCI.pPSOCache            = m_PipelineCache->GetCache();
+    HiZCI.DepthFormat          = m_pSwapChain->GetDesc().DepthBufferFormat;
+    m_HiZ                      = std::make_unique<HiZPyramid>(HiZCI);
+}
+
+void Tutorial03_Texturing::CreateAnimationTexture()
+{
+    // Every object of an animated node gets a track. Generated objects are attached to the
+    // grid node, which does not move. Tracks are grouped by mesh, so every group is one draw.
+    std::vector<Uint32> AnimatedObjects;
+    for (Uint32 i = 0; i < m_Objects.size(); ++i)
+    {
+        if (m_Objects[i].Node != SCENE_NODE_GRID)
+            AnimatedObjects.push_back(i);
+    }
+    std::stable_sort(AnimatedObjects.begin(), AnimatedObjects.end(), [this](Uint32 lhs, Uint32 rhs) {
+        return m_Objects[lhs].Mesh < m_Objects[rhs].Mesh;
+    });
+
+    for (Uint32 Track = 0; Track < AnimatedObjects.size(); ++Track)
+    {
+        SceneObject& Obj   = m_Objects[AnimatedObjects[Track]];
+        Obj.AnimationTrack = Track;
+        if (m_AnimatedGroups.empty() || m_AnimatedGroups.back().Mesh != Obj.Mesh)
+            m_AnimatedGroups.push_back({Obj.Mesh, Track, 0});
+        ++m_AnimatedGroups.back().NumTracks;
+    }
+    if (AnimatedObjects.empty())
+        return;
+
+    AnimationTexture::CreateInfo AnimationCI;
+    AnimationCI.pDevice    = m_pDevice;
+    AnimationCI.NumTracks  = static_cast<Uint32>(AnimatedObjects.size());
+    AnimationCI.NumSamples = AnimationSamples;
+    AnimationCI.Period     = AnimationPeriod;
+    AnimationCI.Evaluate   = [&](float Time, float4x4* pTransforms) {
+        float4x4 NodeTransforms[SCENE_NODE_COUNT];
+        ComputeNodeTransforms(Time, NodeTransforms);
+        for (Uint32 ObjId : AnimatedObjects)
+        {
+            const SceneObject& Obj          = m_Objects[ObjId];
+            pTransforms[Obj.AnimationTrack] = Obj.LocalTransform * NodeTransforms[Obj.Node];
+        }
     };
-    // clang-format on
-    PSOCreateInfo.PSODesc.ResourceLayout.ImmutableSamplers    = ImtblSamplers;
-    PSOCreateInfo.PSODesc.ResourceLayout.NumImmutableSamplers = _countof(ImtblSamplers);
+    m_AnimationTexture = std::make_unique<AnimationTexture>(AnimationCI);
 
-    m_pDevice->CreateGraphicsPipelineState(PSOCreateInfo, &m_pPSO);
+    CreatePipelineState(TRANSFORM_SOURCE_ANIMATION_TEXTURE, false, m_AnimatedPipelines);
+}
 
-    // Since we did not explicitly specify the type for 'Constants' variable, default
-    // type (SHADER_RESOURCE_VARIABLE_TYPE_STATIC) will be used. Static variables
-    // never change and are bound directly through the pipeline state object.
-    m_pPSO->GetStaticVariableByName(SHADER_TYPE_VERTEX, "Constants")->Set(m_VSConstants);
+BoundingSphere Tutorial03_Texturing::GetWorldBoundingSphere(const SceneObject& Obj) const
+{
+    const BoundingSphere& Bounds = m_MeshBounds[Obj.Mesh];
+    const float4x4&       Model  = Obj.ModelTransform;
+
+    // The radius is scaled by the largest axis scale of the model matrix
+    const float4 Center = float4{Bounds.Center, 1} * Model;
+    const float  Scale  = std::sqrt(std::max({
+        Model._11 * Model._11 + Model._12 * Model._12 + Model._13 * Model._13,
+        Model._21 * Model._21 + Model._22 * Model._22 + Model._23 * Model._23,
+        Model._31 * Model._31 + Model._32 * Model._32 + Model._33 * Model._33,
+    }));
+
+    BoundingSphere WorldBounds;
+    WorldBounds.Center = float3{Center.x, Center.y, Center.z};
+    WorldBounds.Radius = Bounds.Radius * Scale;
+    return WorldBounds;
+}
 
-    // Since we are using mutable variable, we must create a shader resource binding object
-    // http://diligentgraphics.com/2016/03/23/resource-binding-model-in-diligent-engine-2-0/
-    m_pPSO->CreateShaderResourceBinding(&m_SRB, true);
+void Tutorial03_Texturing::UpdateUI()
+{
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Settings", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::Combo("Opaque order", reinterpret_cast<int*>(&m_RenderSettings.OpaqueOrder), "Declaration\0Front to back\0\0");
+        ImGui::Checkbox("Depth pre-pass", &m_RenderSettings.DepthPrePass);
+        ImGui::Checkbox("Batching", &m_RenderSettings.Batching);
+        if (m_CommandBundlesSupported)
+        {
+            // Bundles are replayed on the CPU; they skip frame building, not draw submission
+            ImGui::Checkbox("Replay cached draw list", &m_RenderSettings.ReplayDrawList);
+        }
+        if (m_GPUScene)
+        {
+            // Paths can only be enabled once their pipelines are compiled
+            if (m_GPUScenePipelines.IsReady())
+                ImGui::Checkbox("GPU-driven", &m_RenderSettings.GPUDriven);
+            else
+                ImGui::TextDisabled("GPU-driven (compiling)");
+            if (m_RenderSettings.GPUDriven)
+            {
+                ImGui::Text("Draw mode: %s", m_GPUScene->GetDrawModeName());
+                ImGui::Text("Object uploads: %.1f KB", static_cast<double>(m_GPUScene->GetLastUploadSize()) / 1024.0);
+                ImGui::Checkbox("Occlusion culling", &m_RenderSettings.OcclusionCulling);
+                ImGui::Checkbox("GPU animation", &m_RenderSettings.GPUAnimation);
+            }
+        }
+        ImGui::Checkbox("Frustum culling", &m_RenderSettings.FrustumCulling);
+        if (!(m_GPUScene && m_RenderSettings.GPUDriven))
+        {
+            if (m_AnimationTexture)
+            {
+                if (m_AnimatedPipelines.IsReady())
+                    ImGui::Checkbox("Baked animation", &m_RenderSettings.BakedAnimation);
+                else
+                    ImGui::TextDisabled("Baked animation (compiling)");
+            }
+            ImGui::Checkbox("Software occlusion culling", &m_RenderSettings.SoftwareOcclusionCulling);
+            if (m_OcclusionQueries)
+                ImGui::Checkbox("Occlusion queries", &m_RenderSettings.OcclusionQueries);
+            ImGui::Text("Visible objects: %d / %d", static_cast<int>(m_VisibleObjects.size()), static_cast<int>(m_Objects.size()));
+        }
+        const Uint32 MaxGeneratedObjects = MaxGPUSceneObjects - static_cast<Uint32>(m_NumSceneObjects);
+        if (ImGui::SliderInt("Generated cubes", &m_RenderSettings.NumGeneratedObjects, 0, static_cast<int>(MaxGeneratedObjects)))
+            GenerateObjects(static_cast<Uint32>(m_RenderSettings.NumGeneratedObjects));
+        ImGui::Checkbox("Node axes", &m_RenderSettings.ShowNodeAxes);
+        ImGui::Text("Materials: %u, PSOs: %u, SRBs: %u", m_Materials->GetNumMaterials(), m_Materials->GetNumPipelines(), m_Materials->GetNumSRBs());
+        if (m_ShaderOptimizer && m_ShaderOptimizer->GetStatistics().NumShaders > 0)
+        {
+            const ShaderOptimizer::Statistics& Stats = m_ShaderOptimizer->GetStatistics();
+            ImGui::Text("Baked SPIR-V instructions: %u -> %u", static_cast<Uint32>(Stats.InstructionsBefore), static_cast<Uint32>(Stats.InstructionsAfter));
+        }
+    }
+    ImGui::End();
 }
 
-void Tutorial03_Texturing::CreateVertexBuffer()
+void Tutorial03_Texturing::CullObjects()
 {
-    // Layout of this structure matches the one we defined in the pipeline state
-    struct Vertex
+    m_VisibleObjects.clear();
+    if (m_RenderSettings.FrustumCulling)
     {
-        float3 pos;
-        float2 uv;
-    };
+        m_FrustumCuller.Resize(static_cast<Uint32>(m_Objects.size()));
+        for (Uint32 i = 0; i < m_Objects.size(); ++i)
+        {
+            const BoundingSphere Bounds = GetWorldBoundingSphere(m_Objects[i]);
+            m_FrustumCuller.SetSphere(i, Bounds.Center, Bounds.Radius);
+        }
+
+        m_FrustumCuller.Cull(ExtractFrustumPlanes(m_ViewProjMatrix, m_pDevice->GetDeviceInfo().IsGLDevice()), m_VisibleObjects, m_WorkerPool.get());
+    }
+    else
+    {
+        for (Uint32 i = 0; i < m_Objects.size(); ++i)
+            m_VisibleObjects.push_back(i);
+    }
 
-    // Cube vertices
-
-    //      (-1,+1,+1)________________(+1,+1,+1)
-    //               /|              /|
-    //              / |             / |
-    //             /  |            /  |
-    //            /   |           /   |
-    //(-1,-1,+1) /____|__________/(+1,-1,+1)
-    //           |    |__________|____|
-    //           |   /(-1,+1,-1) |    /(+1,+1,-1)
-    //           |  /            |   /
-    //           | /             |  /
-    //           |/              | /
-    //           /_______________|/
-    //        (-1,-1,-1)       (+1,-1,-1)
-    //
-
-    // This time we have to duplicate verices because texture coordinates cannot
-    // be shared
-    constexpr Vertex CubeVerts[] =
-        {
-            {float3{-1, -1, -1}, float2{0, 1}},
-            {float3{-1, +1, -1}, float2{0, 0}},
-            {float3{+1, +1, -1}, float2{1, 0}},
-            {float3{+1, -1, -1}, float2{1, 1}},
-
-            {float3{-1, -1, -1}, float2{0, 1}},
-            {float3{-1, -1, +1}, float2{0, 0}},
-            {float3{+1, -1, +1}, float2{1, 0}},
-            {float3{+1, -1, -1}, float2{1, 1}},
-
-            {float3{+1, -1, -1}, float2{0, 1}},
-            {float3{+1, -1, +1}, float2{1, 1}},
-            {float3{+1, +1, +1}, float2{1, 0}},
-            {float3{+1, +1, -1}, float2{0, 0}},
-
-            {float3{+1, +1, -1}, float2{0, 1}},
-            {float3{+1, +1, +1}, float2{0, 0}},
-            {float3{-1, +1, +1}, float2{1, 0}},
-            {float3{-1, +1, -1}, float2{1, 1}},
-
-            {float3{-1, +1, -1}, float2{1, 0}},
-            {float3{-1, +1, +1}, float2{0, 0}},
-            {float3{-1, -1, +1}, float2{0, 1}},
-            {float3{-1, -1, -1}, float2{1, 1}},
-
-            {float3{-1, -1, +1}, float2{1, 1}},
-            {float3{+1, -1, +1}, float2{0, 1}},
-            {float3{+1, +1, +1}, float2{0, 0}},
-            {float3{-1, +1, +1}, float2{1, 0}},
+    // Baked objects are drawn by RenderAnimatedObjects(), and their transforms are only known on the GPU
+    if (m_RenderSettings.BakedAnimation)
+    {
+        auto Baked = [this](Uint32 ObjId) {
+            return m_Objects[ObjId].AnimationTrack != ~0u;
         };
+        m_VisibleObjects.erase(std::remove_if(m_VisibleObjects.begin(), m_VisibleObjects.end(), Baked), m_VisibleObjects.end());
+    }
 
-    BufferDesc VertBuffDesc;
-    VertBuffDesc.Name      = "Cube vertex buffer";
-    VertBuffDesc.Usage     = USAGE_IMMUTABLE;
-    VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
-    VertBuffDesc.Size      = sizeof(CubeVerts);
-    BufferData VBData;
-    VBData.pData    = CubeVerts;
-    VBData.DataSize = sizeof(CubeVerts);
-    m_pDevice->CreateBuffer(VertBuffDesc, &VBData, &m_CubeVertexBuffer);
+    if (m_RenderSettings.SoftwareOcclusionCulling)
+        CullOccludedObjects();
+
+    if (m_OcclusionQueries && m_RenderSettings.OcclusionQueries)
+        CullObjectsWithQueries();
 }
 
-void Tutorial03_Texturing::CreateIndexBuffer()
+void Tutorial03_Texturing::CullOccludedObjects()
 {
-    // clang-format off
-    constexpr Uint32 Indices[] =
+    // The nearest visible objects are the most likely to hide others
+    std::vector<Uint32> Occluders    = m_VisibleObjects;
+    const size_t        NumOccluders = std::min(Occluders.size(), size_t{MaxSoftwareOccluders});
+    std::partial_sort(Occluders.begin(), Occluders.begin() + NumOccluders, Occluders.end(), [this](Uint32 lhs, Uint32 rhs) {
+        return m_Objects[lhs].ViewDepth < m_Objects[rhs].ViewDepth;
+    });
+
+    m_SoftwareOcclusion->BeginFrame(m_ViewProjMatrix);
+    for (size_t i = 0; i < NumOccluders; ++i)
     {
-        2,0,1,    2,3,0,
-        4,6,5,    4,7,6,
-        8,10,9,   8,11,10,
-        12,14,13, 12,15,14,
-        16,18,17, 16,19,18,
-        20,21,22, 20,22,23
+        const SceneObject& Obj = m_Objects[Occluders[i]];
+        m_SoftwareOcclusion->AddOccluder(m_MeshData[Obj.Mesh], Obj.ModelTransform);
+    }
+    m_SoftwareOcclusion->Rasterize();
+
+    // Occluders are tested too. The nearest point of their bounds is in front of their own
+    // surface, so an occluder is only removed when other occluders hide it.
+    auto Occluded = [this](Uint32 ObjId) {
+        const BoundingSphere Bounds = GetWorldBoundingSphere(m_Objects[ObjId]);
+        return m_SoftwareOcclusion->IsSphereOccluded(Bounds.Center, Bounds.Radius);
     };
-    // clang-format on
+    m_VisibleObjects.erase(std::remove_if(m_VisibleObjects.begin(), m_VisibleObjects.end(), Occluded), m_VisibleObjects.end());
+}
 
-    BufferDesc IndBuffDesc;
-    IndBuffDesc.Name      = "Cube index buffer";
-    IndBuffDesc.Usage     = USAGE_IMMUTABLE;
-    IndBuffDesc.BindFlags = BIND_INDEX_BUFFER;
-    IndBuffDesc.Size      = sizeof(Indices);
-    BufferData IBData;
-    IBData.pData    = Indices;
-    IBData.DataSize = sizeof(Indices);
-    m_pDevice->CreateBuffer(IndBuffDesc, &IBData, &m_CubeIndexBuffer);
+void Tutorial03_Texturing::CullObjectsWithQueries()
+{
+    m_OcclusionQueries->BeginFrame(static_cast<Uint32>(m_Objects.size()));
+
+    auto Occluded = [this](Uint32 ObjId) {
+        const SceneObject& Obj = m_Objects[ObjId];
+        // A query only covers one object, so batched objects are not tested
+        if (m_RenderSettings.Batching && (Obj.Batched || Obj.Streamed))
+            return false;
+
+        // Boxes clipped by the near plane could be reported as hidden while the camera is inside them
+        const BoundingSphere Bounds      = GetWorldBoundingSphere(Obj);
+        const float          CenterDepth = (float4{Bounds.Center, 1} * m_ViewMatrix).z;
+        if (CenterDepth - Bounds.Radius * std::sqrt(3.f) <= CameraNearPlane)
+            return false;
+
+        // The result comes from a previous frame, and the box is tested again in this one
+        const bool WasOccluded = m_OcclusionQueries->IsOccluded(ObjId);
+        const float4x4 BoxTransform =
+            float4x4::Scale(Bounds.Radius, Bounds.Radius, Bounds.Radius) * float4x4::Translation(Bounds.Center.x, Bounds.Center.y, Bounds.Center.z);
+        m_OcclusionQueries->Test(ObjId, BoxTransform);
+        return WasOccluded;
+    };
+    m_VisibleObjects.erase(std::remove_if(m_VisibleObjects.begin(), m_VisibleObjects.end(), Occluded), m_VisibleObjects.end());
 }
 
-void Tutorial03_Texturing::LoadTexture()
+void Tutorial03_Texturing::PrepareDrawItems()
 {
-    TextureLoadInfo loadInfo;
-    loadInfo.IsSRGB = true;
-    RefCntAutoPtr<ITexture> Tex;
-    CreateTextureFromFile("DGLogo.png", loadInfo, m_pDevice, &Tex);
-    // Get shader resource view from the texture
-    m_TextureSRV = Tex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+    m_DrawItems.clear();
+
+    auto AddMeshItem = [this](const GeometryPool::MeshHandle& Mesh, const float4x4& WorldViewProj, float ViewDepth) {
+        DrawItem Item;
+        Item.pVertexBuffer      = m_GeometryPool->GetVertexBuffer();
+        Item.pPositionBuffer    = m_GeometryPool->GetPositionBuffer();
+        Item.pIndexBuffer       = m_GeometryPool->GetIndexBuffer();
+        Item.NumIndices         = Mesh.NumIndices;
+        Item.FirstIndexLocation = Mesh.FirstIndexLocation;
+        Item.BaseVertex         = Mesh.BaseVertex;
+        Item.WorldViewProj      = WorldViewProj;
+        Item.ViewDepth          = ViewDepth;
+        m_DrawItems.push_back(Item);
+    };
+
+    auto AddObjectItem = [&](const SceneObject& Obj) {
+        AddMeshItem(m_Meshes[Obj.Mesh], Obj.WorldViewProj, Obj.ViewDepth);
+    };
+
+    if (!m_RenderSettings.Batching)
+    {
+        for (Uint32 ObjId : m_VisibleObjects)
+            AddObjectItem(m_Objects[ObjId]);
+        return;
+    }
+
+    // A static batch is drawn if any of its objects is visible
+    std::vector<bool> BatchVisible(m_StaticBatches.size());
+    for (Uint32 ObjId : m_VisibleObjects)
+    {
+        const SceneObject& Obj = m_Objects[ObjId];
+        if (Obj.Batched)
+            BatchVisible[Obj.BatchId] = true;
+    }
+
+    for (size_t i = 0; i < m_StaticBatches.size(); ++i)
+    {
+        if (!BatchVisible[i])
+            continue;
+
+        const float4x4& NodeTransform = m_NodeTransforms[m_StaticBatches[i].Node];
+        AddMeshItem(m_StaticBatches[i].pBatch->GetMesh(), NodeTransform * m_ViewProjMatrix, (float4{0, 0, 0, 1} * NodeTransform * m_ViewMatrix).z);
+    }
+
+    std::vector<const SceneObject*> StreamedObjects;
+    for (Uint32 ObjId : m_VisibleObjects)
+    {
+        const SceneObject& Obj = m_Objects[ObjId];
+        if (Obj.Streamed)
+            StreamedObjects.push_back(&Obj);
+        else if (!Obj.Batched)
+            AddObjectItem(Obj);
+    }
 
-    // Set texture SRV in the SRB
-    m_SRB->GetVariableByName(SHADER_TYPE_PIXEL, "g_Texture")->Set(m_TextureSRV);
+    if (!StreamedObjects.empty())
+    {
+        // Front-to-back order matters within the batch too
+        if (m_RenderSettings.OpaqueOrder == OPAQUE_ORDER_FRONT_TO_BACK)
+        {
+            std::sort(StreamedObjects.begin(), StreamedObjects.end(), [](const SceneObject* lhs, const SceneObject* rhs) {
+                return lhs->ViewDepth < rhs->ViewDepth;
+            });
+        }
+
+        DrawItem Item;
+        Item.pVertexBuffer   = m_DynamicBatch->GetVertexBuffer();
+        Item.pPositionBuffer = m_DynamicBatch->GetPositionBuffer();
+        Item.pIndexBuffer    = m_DynamicBatch->GetIndexBuffer();
+        Item.WorldViewProj   = m_ViewProjMatrix;
+        Item.ViewDepth       = StreamedObjects.front()->ViewDepth;
+
+        m_DynamicBatch->Begin(m_pImmediateContext);
+        for (const SceneObject* pObj : StreamedObjects)
+        {
+            // Objects that do not fit are drawn separately
+            if (!m_DynamicBatch->Append(m_MeshData[pObj->Mesh], pObj->ModelTransform))
+                AddObjectItem(*pObj);
+            Item.ViewDepth = std::min(Item.ViewDepth, pObj->ViewDepth);
+        }
+        m_DynamicBatch->End();
+
+        Item.NumIndices = m_DynamicBatch->GetNumIndices();
+        if (Item.NumIndices > 0)
+            m_DrawItems.push_back(Item);
+    }
 }
 
+void Tutorial03_Texturing::SortDrawItems()
+{
+    if (m_RenderSettings.OpaqueOrder == OPAQUE_ORDER_FRONT_TO_BACK)
+    {
+        // Nearest objects first so that farther fragments fail the depth test early
+        // instead of being shaded and then overwritten.
+        std::sort(m_DrawItems.begin(), m_DrawItems.end(), [](const DrawItem& lhs, const DrawItem& rhs) {
+            return lhs.ViewDepth < rhs.ViewDepth;
+        });
+    }
+}
 
-void Tutorial03_Texturing::Initialize(const SampleInitInfo& InitInfo)
+void Tutorial03_Texturing::DrawItems(bool PositionsOnly)
 {
-    SampleBase::Initialize(InitInfo);
+    IBuffer* pBoundVB = nullptr;
+    IBuffer* pBoundIB = nullptr;
+    for (const DrawItem& Item : m_DrawItems)
+    {
+        // Bind vertex and index buffers
+        IBuffer* pVB = PositionsOnly ? Item.pPositionBuffer : Item.pVertexBuffer;
+        if (pVB != pBoundVB)
+        {
+            const Uint64 offset   = 0;
+            IBuffer*     pBuffs[] = {pVB};
+            m_pImmediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+            pBoundVB = pVB;
+        }
+        if (Item.pIndexBuffer != pBoundIB)
+        {
+            m_pImmediateContext->SetIndexBuffer(Item.pIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            pBoundIB = Item.pIndexBuffer;
+        }
 
-    CreatePipelineState();
-    CreateVertexBuffer();
-    CreateIndexBuffer();
-    LoadTexture();
+        // Map the buffer and write current world-view-projection matrix. The buffer is dynamic,
+        // so the new contents are picked up by the draw without committing the SRB again.
+        {
+            MapHelper<float4x4> CBConstants(m_pImmediateContext, m_VSConstants, MAP_WRITE, MAP_FLAG_DISCARD);
+            *CBConstants = Item.WorldViewProj;
+        }
+
+        DrawIndexedAttribs DrawAttrs;
+        DrawAttrs.IndexType          = VT_UINT32;
+        DrawAttrs.NumIndices         = Item.NumIndices;
+        DrawAttrs.FirstIndexLocation = Item.FirstIndexLocation;
+        DrawAttrs.BaseVertex         = Item.BaseVertex;
+        DrawAttrs.Flags              = DRAW_FLAG_VERIFY_ALL;
+        m_pImmediateContext->DrawIndexed(DrawAttrs);
+    }
+}
+
+bool Tutorial03_Texturing::UpdateCommandBundles()
+{
+    if (m_DrawItems.size() > MaxBundleDraws)
+        return false;
+
+    // Bundles only need to be re-recorded when the structure of the frame changes.
+    // Transforms are not part of the recorded commands.
+    std::vector<BundleDrawKey> Signature;
+    Signature.reserve(m_DrawItems.size());
+    for (const DrawItem& Item : m_DrawItems)
+        Signature.push_back({Item.pVertexBuffer, Item.pIndexBuffer, Item.NumIndices, Item.FirstIndexLocation, Item.BaseVertex});
+
+    if (Signature == m_BundleSignature && m_BundleDepthPrePass == m_RenderSettings.DepthPrePass)
+        return true;
+
+    auto RecordBundle = [this](CommandBundle& Bundle, IPipelineState* pPSO, bool PositionsOnly) {
+        Bundle.Reset();
+        Bundle.SetPipelineState(pPSO);
+        // All draws read their transform from the same buffer, so resources are committed once
+        Bundle.CommitShaderResources(m_BundlePipelines.pTransformSRB);
+        if (!PositionsOnly)
+            Bundle.CommitShaderResources(m_Materials->GetSRB(m_DefaultMaterial));
+
+        IBuffer* pBoundVB = nullptr;
+        IBuffer* pBoundIB = nullptr;
+        for (Uint32 i = 0; i < m_DrawItems.size(); ++i)
+        {
+            const DrawItem& Item = m_DrawItems[i];
+            IBuffer*        pVB  = PositionsOnly ? Item.pPositionBuffer : Item.pVertexBuffer;
+            if (pVB != pBoundVB)
+            {
+                IBuffer* pBuffs[] = {pVB, m_DrawIdBuffer};
+                Bundle.SetVertexBuffers(0, _countof(pBuffs), pBuffs, nullptr);
+                pBoundVB = pVB;
+            }
+            if (Item.pIndexBuffer != pBoundIB)
+            {
+                Bundle.SetIndexBuffer(Item.pIndexBuffer, 0);
+                pBoundIB = Item.pIndexBuffer;
+            }
+
+            DrawIndexedAttribs DrawAttrs;
+            DrawAttrs.IndexType             = VT_UINT32;
+            DrawAttrs.NumIndices            = Item.NumIndices;
+            DrawAttrs.FirstIndexLocation    = Item.FirstIndexLocation;
+            DrawAttrs.BaseVertex            = Item.BaseVertex;
+            DrawAttrs.FirstInstanceLocation = i;
+            Bundle.DrawIndexed(DrawAttrs);
+        }
+    };
+
+    if (m_RenderSettings.DepthPrePass)
+    {
+        RecordBundle(m_DepthPrePassBundle, m_BundlePipelines.pDepthPrePassPSO, true);
+        RecordBundle(m_ColorBundle, m_BundlePipelines.pDepthEqualPSO, false);
+    }
+    else
+    {
+        m_DepthPrePassBundle.Reset();
+        RecordBundle(m_ColorBundle, m_BundlePipelines.pColorPSO, false);
+    }
+
+    m_BundleSignature    = std::move(Signature);
+    m_BundleDepthPrePass = m_RenderSettings.DepthPrePass;
+    return true;
+}
+
+void Tutorial03_Texturing::RenderDrawItems(ITextureView* pRTV, ITextureView* pDSV)
+{
+    if (m_CommandBundlesSupported && m_RenderSettings.ReplayDrawList && m_BundlePipelines.IsReady() && UpdateCommandBundles())
+    {
+        // The only per-frame data are the transforms of the recorded draws
+        {
+            MapHelper<float4x4> DrawTransforms(m_pImmediateContext, m_DrawTransformsCB, MAP_WRITE, MAP_FLAG_DISCARD);
+            for (size_t i = 0; i < m_DrawItems.size(); ++i)
+                DrawTransforms[i] = m_DrawItems[i].WorldViewProj;
+        }
+
+        if (m_RenderSettings.DepthPrePass)
+        {
+            m_pImmediateContext->SetRenderTargets(0, nullptr, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            m_DepthPrePassBundle.Execute(m_pImmediateContext);
+            m_pImmediateContext->SetRenderTargets(1, &pRTV, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        }
+        m_ColorBundle.Execute(m_pImmediateContext);
+    }
+    else if (m_RenderSettings.DepthPrePass)
+    {
+        // Lay down depth with a position-only pass. No render target is bound, so
+        // only the depth buffer is written.
+        m_pImmediateContext->SetRenderTargets(0, nullptr, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_pImmediateContext->SetPipelineState(m_Pipelines.pDepthPrePassPSO);
+        m_pImmediateContext->CommitShaderResources(m_Pipelines.pTransformSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        DrawItems(true);
+
+        // Every visible pixel is now shaded exactly once. Both pipelines share the transform
+        // signature, so only the material resources need to be committed.
+        m_pImmediateContext->SetRenderTargets(1, &pRTV, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_pImmediateContext->SetPipelineState(m_Pipelines.pDepthEqualPSO);
+        m_pImmediateContext->CommitShaderResources(m_Materials->GetSRB(m_DefaultMaterial), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        DrawItems(false);
+    }
+    else
+    {
+        // Set the pipeline state
+        m_pImmediateContext->SetPipelineState(m_Pipelines.pColorPSO);
+        m_pImmediateContext->CommitShaderResources(m_Pipelines.pTransformSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_pImmediateContext->CommitShaderResources(m_Materials->GetSRB(m_DefaultMaterial), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        DrawItems(false);
+    }
+}
+
+void Tutorial03_Texturing::UploadGPUAnimations()
+{
+    // All objects of a node share its steps
+    std::vector<GPUAnimation::Step> Steps;
+    Uint32                          NodeFirstStep[SCENE_NODE_COUNT] = {};
+    Uint32                          NodeNumSteps[SCENE_NODE_COUNT]  = {};
+    for (Uint32 Node = 0; Node < SCENE_NODE_COUNT; ++Node)
+    {
+        NodeFirstStep[Node] = static_cast<Uint32>(Steps.size());
+        GetNodeAnimationSteps(Node, Steps);
+        NodeNumSteps[Node] = static_cast<Uint32>(Steps.size()) - NodeFirstStep[Node];
+    }
+
+    std::vector<GPUAnimation::ObjectAnimation> Animations;
+    Animations.reserve(m_Objects.size());
+    for (const SceneObject& Obj : m_Objects)
+    {
+        GPUAnimation::ObjectAnimation Anim;
+        Anim.Local     = Obj.LocalTransform;
+        Anim.FirstStep = NodeFirstStep[Obj.Node];
+        Anim.NumSteps  = NodeNumSteps[Obj.Node];
+        Animations.push_back(Anim);
+    }
+
+    m_GPUAnimation->SetAnimations(m_pImmediateContext, Animations.data(), static_cast<Uint32>(Animations.size()), Steps.data(), static_cast<Uint32>(Steps.size()));
+}
+
+void Tutorial03_Texturing::RenderGPUScene(ITextureView* pRTV, ITextureView* pDSV)
+{
+    // With GPU animation, the records only change with the set of objects,
+    // and their world transforms are written by the animation pass.
+    // Otherwise, the records of the objects that moved were updated in place by Update().
+    if (m_RenderSettings.GPUAnimation ? m_GPUAnimationDirty : m_RebuildGPUSceneObjects)
+    {
+        m_GPUSceneObjects.clear();
+        for (const SceneObject& Obj : m_Objects)
+        {
+            const GeometryPool::MeshHandle& Mesh = m_Meshes[Obj.Mesh];
+
+            GPUScene::ObjectData Data;
+            Data.World              = Obj.ModelTransform;
+            Data.BoundingSphere     = float4{m_MeshBounds[Obj.Mesh].Center, m_MeshBounds[Obj.Mesh].Radius};
+            Data.FirstIndexLocation = Mesh.FirstIndexLocation;
+            Data.NumIndices         = Mesh.NumIndices;
+            Data.BaseVertex         = Mesh.BaseVertex;
+            Data.VertexFormat       = Mesh.VertexFormat;
+            Data.VertexBase         = Mesh.VertexBase;
+            m_GPUSceneObjects.push_back(Data);
+        }
+
+        m_GPUScene->SetObjects(m_pImmediateContext, m_GPUSceneObjects.data(), static_cast<Uint32>(m_GPUSceneObjects.size()));
+        m_RebuildGPUSceneObjects = false;
+    }
+    else if (!m_RenderSettings.GPUAnimation)
+    {
+        m_GPUScene->UpdateObjects(m_pImmediateContext, m_GPUSceneObjects.data(), m_DirtyGPUSceneObjects.data(), static_cast<Uint32>(m_DirtyGPUSceneObjects.size()));
+    }
+    m_DirtyGPUSceneObjects.clear();
+
+    if (m_RenderSettings.GPUAnimation)
+    {
+        if (m_GPUAnimationDirty)
+        {
+            UploadGPUAnimations();
+            m_GPUAnimationDirty = false;
+        }
+
+        // All speeds of the steps complete whole turns over the period, so the time is wrapped
+        // in double precision to keep the angles accurate in float
+        m_GPUAnimation->Update(m_pImmediateContext, static_cast<float>(std::fmod(m_CurrTime, double{AnimationPeriod})));
+        // The pass writes the records, so the copies kept for delta uploads are out of date
+        m_GPUScene->InvalidateObjects();
+    }
+
+    m_GPUScene->SetView(m_pImmediateContext, m_ViewProjMatrix, m_RenderSettings.FrustumCulling);
+
+    const ScenePipelines& Pipelines = m_GPUScenePipelines;
+
+    auto DrawScene = [&](IPipelineState* pPSO, bool PositionsOnly) {
+        m_pImmediateContext->SetPipelineState(pPSO);
+
+        // All objects live in the geometry pool, so buffers are bound once for the whole scene.
+        // Pulled vertices are read through the SRB, and only the draw ids go through the input assembler.
+        IBuffer* pBuffs[] = {m_DrawIdBuffer};
+        m_pImmediateContext->SetVertexBuffers(0, _countof(pBuffs), pBuffs, nullptr, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+        m_pImmediateContext->SetIndexBuffer(m_GeometryPool->GetIndexBuffer(), 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        // Culling passes run compute pipelines between the draws, so the SRBs are committed every time
+        m_pImmediateContext->CommitShaderResources(Pipelines.pTransformSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        if (!PositionsOnly)
+            m_pImmediateContext->CommitShaderResources(m_Materials->GetSRB(m_DefaultMaterial), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        m_GPUScene->Draw(m_pImmediateContext);
+    };
+
+    auto DrawPhase = [&](GPUScene::CULL_PHASE Phase, ITextureView* pHiZSRV) {
+        m_GPUScene->GenerateDraws(m_pImmediateContext, Phase, pHiZSRV);
+
+        if (m_RenderSettings.DepthPrePass)
+        {
+            m_pImmediateContext->SetRenderTargets(0, nullptr, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            DrawScene(Pipelines.pDepthPrePassPSO, true);
+            m_pImmediateContext->SetRenderTargets(1, &pRTV, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            DrawScene(Pipelines.pDepthEqualPSO, false);
+        }
+        else
+        {
+            DrawScene(Pipelines.pColorPSO, false);
+        }
+    };
+
+    if (!m_RenderSettings.OcclusionCulling)
+    {
+        DrawPhase(GPUScene::CULL_PHASE_NONE, nullptr);
+        return;
+    }
+
+    const SwapChainDesc& SCDesc = m_pSwapChain->GetDesc();
+    m_HiZ->Resize(SCDesc.Width, SCDesc.Height);
+
+    pDSV = m_HiZ->GetDepthDSV();
+    m_pImmediateContext->SetRenderTargets(1, &pRTV, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    m_pImmediateContext->ClearDepthStencil(pDSV, CLEAR_DEPTH_FLAG, 1.f, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    DrawPhase(GPUScene::CULL_PHASE_PREVIOUSLY_VISIBLE, nullptr);
+
+    // The depth buffer is read while the pyramid is built
+    m_pImmediateContext->SetRenderTargets(0, nullptr, nullptr, RESOURCE_STATE_TRANSITION_MODE_NONE);
+    m_HiZ->Build(m_pImmediateContext);
+    m_pImmediateContext->SetRenderTargets(1, &pRTV, pDSV, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    DrawPhase(GPUScene::CULL_PHASE_OCCLUSION, m_HiZ->GetPyramidSRV());
+
+    // The depth buffer stays bound, so overlays are depth-tested against the scene
+}
+
+void Tutorial03_Texturing::RenderAnimatedObjects()
+{
+    // The only per-frame data are the view and the sample position
+    m_AnimationTexture->SetView(m_pImmediateContext, m_ViewProjMatrix, m_CurrTime);
+
+    m_pImmediateContext->SetPipelineState(m_AnimatedPipelines.pColorPSO);
+    m_pImmediateContext->CommitShaderResources(m_AnimatedPipelines.pTransformSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    m_pImmediateContext->CommitShaderResources(m_Materials->GetSRB(m_DefaultMaterial), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    m_pImmediateContext->SetIndexBuffer(m_GeometryPool->GetIndexBuffer(), 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    for (const AnimatedGroup& Group : m_AnimatedGroups)
+    {
+        // Instance N of the group reads the draw id FirstTrack + N. The offset is applied to
+        // the buffer rather than through FirstInstanceLocation, which GLES does not support.
+        const Uint64 Offsets[] = {0, Uint64{Group.FirstTrack} * sizeof(Uint32)};
+        IBuffer*     pBuffs[]  = {m_GeometryPool->GetVertexBuffer(), m_DrawIdBuffer};
+        m_pImmediateContext->SetVertexBuffers(0, _countof(pBuffs), pBuffs, Offsets, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+
+        const GeometryPool::MeshHandle& Mesh = m_Meshes[Group.Mesh];
+
+        DrawIndexedAttribs DrawAttrs;
+        DrawAttrs.IndexType          = VT_UINT32;
+        DrawAttrs.NumIndices         = Mesh.NumIndices;
+        DrawAttrs.FirstIndexLocation = Mesh.FirstIndexLocation;
+        DrawAttrs.BaseVertex         = Mesh.BaseVertex;
+        DrawAttrs.NumInstances       = Group.NumTracks;
+        DrawAttrs.Flags              = DRAW_FLAG_VERIFY_ALL;
+        m_pImmediateContext->DrawIndexed(DrawAttrs);
+    }
 }
 
 // Render a frame
@@ -279,114 +1525,127 @@ void Tutorial03_Texturing::Render()
     m_pImmediateContext->ClearRenderTarget(pRTV, ClearColor.Data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
     m_pImmediateContext->ClearDepthStencil(pDSV, CLEAR_DEPTH_FLAG, 1.f, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
-    // Bind vertex and index buffers
-    const Uint64 offset   = 0;
-    IBuffer*     pBuffs[] = {m_CubeVertexBuffer};
-    m_pImmediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
-    m_pImmediateContext->SetIndexBuffer(m_CubeIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-
-    // Set the pipeline state
-    m_pImmediateContext->SetPipelineState(m_pPSO);
-
-    // Función auxiliar para dibujar un cubo
-    auto DrawCube = [&](const float4x4& WorldViewProjMatrix) {
-        // Map the buffer and write current world-view-projection matrix
-        MapHelper<float4x4> CBConstants(m_pImmediateContext, m_VSConstants, MAP_WRITE, MAP_FLAG_DISCARD);
-        *CBConstants = WorldViewProjMatrix;
-
-        // Commit shader resources
-        m_pImmediateContext->CommitShaderResources(m_SRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-
-        // Draw the cube
-        DrawIndexedAttribs DrawAttrs;
-        DrawAttrs.IndexType  = VT_UINT32;
-        DrawAttrs.NumIndices = 36;
-        DrawAttrs.Flags      = DRAW_FLAG_VERIFY_ALL;
-        m_pImmediateContext->DrawIndexed(DrawAttrs);
-    };
+    if (m_GPUScene && m_RenderSettings.GPUDriven)
+    {
+        RenderGPUScene(pRTV, pDSV);
+    }
+    else
+    {
+        CullObjects();
+        PrepareDrawItems();
+        SortDrawItems();
+        RenderDrawItems(pRTV, pDSV);
+
+        // Baked objects are not part of the depth pre-pass, so they use the regular depth test
+        if (m_AnimationTexture && m_RenderSettings.BakedAnimation)
+            RenderAnimatedObjects();
+
+        // Boxes are tested against the depth of the whole scene, and the results are used in later frames
+        if (m_OcclusionQueries && m_RenderSettings.OcclusionQueries)
+            m_OcclusionQueries->Render(m_pImmediateContext, m_ViewProjMatrix);
+    }
 
-    // Dibujar los doce cubos
-    DrawCube(m_WorldViewProjMatrix1);  // Cubo central
-    DrawCube(m_WorldViewProjMatrix2);  // Cubo derecho
-    DrawCube(m_WorldViewProjMatrix3);  // Cubo izquierdo
-    DrawCube(m_WorldViewProjMatrix4);  // Cubo debajo del derecho
-    DrawCube(m_WorldViewProjMatrix5);  // Cubo debajo del izquierdo
-    DrawCube(m_WorldViewProjMatrix6);  // Cubo a la derecha del cubo 4 (órbita + rotación propia)
-    DrawCube(m_WorldViewProjMatrix7);  // Cubo a la izquierda del cubo 4 (órbita + rotación propia)
-    DrawCube(m_WorldViewProjMatrix8);  // Cubo arriba del cubo central
-    DrawCube(m_WorldViewProjMatrix9);  // Cubo alargado (línea entre cubo central y cubo 8)
-    DrawCube(m_WorldViewProjMatrix10); // Cubo alargado (línea entre cubo 2 y cubo 3)
-    DrawCube(m_WorldViewProjMatrix11); // Cubo alargado (línea entre cubo 2 y cubo 4)
-    DrawCube(m_WorldViewProjMatrix12); // Cubo alargado (línea entre cubo 3 y cubo 5)
+    // Overlays go last so that they are depth-tested against the whole scene
+    m_DebugDraw->Render(m_pImmediateContext, m_ViewProjMatrix);
 }
 
-void Tutorial03_Texturing::Update(double CurrTime, double ElapsedTime)
+void Tutorial03_Texturing::ComputeNodeTransforms(float Time, float4x4* pNodeTransforms)
 {
-    SampleBase::Update(CurrTime, ElapsedTime);
-
     // Apply rotation to the central cube (Cube1)
-    float4x4 Cube1ModelTransform = float4x4::RotationY(static_cast<float>(CurrTime) * 1.0f) * float4x4::RotationX(-PI_F * 0.1f);
+    float4x4 Cube1ModelTransform = float4x4::RotationY(Time * 1.0f) * float4x4::RotationX(-PI_F * 0.1f);
 
-    float4x4 Cube8ModelTransform = float4x4::RotationY(static_cast<float>(CurrTime) * -0.50f) * float4x4::RotationX(-PI_F * 0.1f);
-    // Aplicar rotación en Y al cubo 4 y 8 sobre su propio eje
-    float    rotationSpeed = 1.0f; // Velocidad de rotación
-    float4x4 Cube4Rotation = float4x4::RotationY(static_cast<float>(CurrTime) * 1.0f);
-    float4x4 Cube8Rotation = float4x4::RotationY(static_cast<float>(CurrTime) * 1.0f);
+    float4x4 Cube8ModelTransform = float4x4::RotationY(Time * -0.50f) * float4x4::RotationX(-PI_F * 0.1f);
 
-
-    // Cubos 2, 3, 4 y 5 usan la misma rotación que el cubo central
-    float4x4 Cube2ModelTransform = Cube1ModelTransform; // Cubo derecho
-    float4x4 Cube3ModelTransform = Cube1ModelTransform; // Cubo izquierdo     
-    float4x4 Cube4ModelTransform = Cube1ModelTransform;// Cubo debajo del derecho
-    float4x4 Cube5ModelTransform = Cube1ModelTransform; // Cubo debajo del izquierdo
-
-    // Posicionar los cubos principales
-    Cube2ModelTransform = float4x4::Translation(3.0f, 0.0f, 0.0f) * Cube2ModelTransform;   // Cubo derecho
-    Cube3ModelTransform = float4x4::Translation(-3.0f, 0.0f, 0.0f) * Cube3ModelTransform;  // Cubo izquierdo
-    Cube4ModelTransform = float4x4::Translation(3.0f, -3.0f, 0.0f) * Cube4ModelTransform;  // Cubo debajo del derecho
-    Cube5ModelTransform = float4x4::Translation(-3.0f, -4.0f, 0.0f) * Cube5ModelTransform; // Cubo debajo del izquierdo
+    // Cubos 4 y 5 usan la misma rotación que el cubo central
+    float4x4 Cube4ModelTransform = float4x4::Translation(3.0f, -3.0f, 0.0f) * Cube1ModelTransform;  // Cubo debajo del derecho
+    float4x4 Cube5ModelTransform = float4x4::Translation(-3.0f, -4.0f, 0.0f) * Cube1ModelTransform; // Cubo debajo del izquierdo
 
     // Cubo 8: Arriba del cubo central
-                                             // Misma rotación que el cubo central
     Cube8ModelTransform = float4x4::Translation(0.0f, 5.0f, 0.0f) * Cube8ModelTransform; // Posicionar arriba del cubo central
 
-    // Cubo alargado (línea entre el cubo central y el cubo 8)
-    float4x4 CubeLineModelTransform = Cube1ModelTransform;                                              // Misma rotación que el cubo central
-    CubeLineModelTransform          = float4x4::Scale(0.1f, 2.0f, 0.1f) * CubeLineModelTransform;       // Escalar para hacerlo delgado y alto
-    CubeLineModelTransform          = float4x4::Translation(0.0f, 1.0f, 0.0f) * CubeLineModelTransform; // Posicionar entre el cubo central y el cubo 8
-
-    // Cubo alargado (línea entre el cubo 2 y el cubo 3)
-    float4x4 CubeLine23ModelTransform = Cube1ModelTransform;                                                // Misma rotación que el cubo central
-    CubeLine23ModelTransform          = float4x4::Scale(4.0f, 0.1f, 0.1f) * CubeLine23ModelTransform;       // Escalar para hacerlo largo y delgado en el eje X
-    CubeLine23ModelTransform          = float4x4::Translation(0.0f, 0.0f, 0.0f) * CubeLine23ModelTransform; // Posicionar entre el cubo 2 y el cubo 3
-
-    // Cubo alargado (línea entre el cubo 2 y el cubo 4)
-    float4x4 CubeLine24ModelTransform = Cube1ModelTransform;                                                  // Misma rotación que el cubo central
-    CubeLine24ModelTransform          = float4x4::Scale(0.1f, 2.0f, 0.1f) * CubeLine24ModelTransform;         // Escalar para hacerlo delgado y alto
-    CubeLine24ModelTransform          = float4x4::Translation(30.0f, -1.0f, 0.0f) * CubeLine24ModelTransform; // Posicionar entre el cubo 2 y el cubo 4
-
-    // Cubo alargado (línea entre el cubo 3 y el cubo 5)
-    float4x4 CubeLine35ModelTransform = Cube1ModelTransform;                                                   // Misma rotación que el cubo central
-    CubeLine35ModelTransform          = float4x4::Scale(0.1f, 2.0f, 0.1f) * CubeLine35ModelTransform;          // Escalar para hacerlo delgado y alto
-    CubeLine35ModelTransform          = float4x4::Translation(-30.0f, -1.0f, 0.0f) * CubeLine35ModelTransform; // Posicionar entre el cubo 3 y el cubo 5
-
     // Calcular la posición de los cubos 6 y 7 en relación con el cubo 4
     float orbitRadius = 1.0f;  // Radio de la órbita alrededor del cubo 4
     float orbitSpeed  = 0.3f; // Velocidad de la órbita
 
     // Rotación local sobre el propio eje Y de los cubos 6 y 7
-    float    localRotationSpeed = 0.5f;                                                                   // Velocidad de rotación local
-    float4x4 Cube6LocalRotation = float4x4::RotationY(static_cast<float>(CurrTime) * localRotationSpeed); // Rotación local del cubo 6
-    float4x4 Cube7LocalRotation = float4x4::RotationY(static_cast<float>(CurrTime) * localRotationSpeed); // Rotación local del cubo 7
+    float    localRotationSpeed = 0.5f;                                           // Velocidad de rotación local
+    float4x4 Cube6LocalRotation = float4x4::RotationY(Time * localRotationSpeed); // Rotación local del cubo 6
+    float4x4 Cube7LocalRotation = float4x4::RotationY(Time * localRotationSpeed); // Rotación local del cubo 7
 
     // Cubo 6: Orbita a la derecha del cubo 4
-    float4x4 Cube6OrbitTransform = float4x4::RotationY(static_cast<float>(CurrTime) * orbitSpeed) * float4x4::Translation(orbitRadius, 0.0f, 0.0f);
+    float4x4 Cube6OrbitTransform = float4x4::RotationY(Time * orbitSpeed) * float4x4::Translation(orbitRadius, 0.0f, 0.0f);
     float4x4 Cube6ModelTransform = Cube5ModelTransform * Cube6OrbitTransform * Cube6LocalRotation * Cube4ModelTransform; // Aplicar rotación local, órbita y rotación del cubo 1
 
     // Cubo 7: Orbita a la izquierda del cubo 4
-    float4x4 Cube7OrbitTransform = float4x4::RotationY(static_cast<float>(CurrTime) * orbitSpeed + PI_F) * float4x4::Translation(orbitRadius, 0.0f, 0.0f);
+    float4x4 Cube7OrbitTransform = float4x4::RotationY(Time * orbitSpeed + PI_F) * float4x4::Translation(orbitRadius, 0.0f, 0.0f);
     float4x4 Cube7ModelTransform =  Cube5ModelTransform * Cube7OrbitTransform * Cube7LocalRotation * Cube4ModelTransform; // Aplicar rotación local, órbita y rotación del cubo 1
 
+    pNodeTransforms[SCENE_NODE_CUBE1] = Cube1ModelTransform;
+    pNodeTransforms[SCENE_NODE_CUBE6] = Cube6ModelTransform;
+    pNodeTransforms[SCENE_NODE_CUBE7] = Cube7ModelTransform;
+    pNodeTransforms[SCENE_NODE_CUBE8] = Cube8ModelTransform;
+    pNodeTransforms[SCENE_NODE_GRID]  = float4x4::Identity();
+}
+
+void Tutorial03_Texturing::GetNodeAnimationSteps(Uint32 Node, std::vector<GPUAnimation::Step>& Steps)
+{
+    // Must match ComputeNodeTransforms(). Steps are applied in the order of the matrix products there.
+    using Step = GPUAnimation::Step;
+    switch (Node)
+    {
+        case SCENE_NODE_CUBE1:
+            Steps.push_back(Step::Rotate(float3{0, 1, 0}, 1.0f));
+            Steps.push_back(Step::Rotate(float3{1, 0, 0}, 0.0f, -PI_F * 0.1f));
+            break;
+
+        case SCENE_NODE_CUBE6:
+        case SCENE_NODE_CUBE7:
+            // Transform of cube 5, orbit and local rotation, then transform of cube 4
+            Steps.push_back(Step::Translate(float3{-3, -4, 0}));
+            GetNodeAnimationSteps(SCENE_NODE_CUBE1, Steps);
+            Steps.push_back(Step::Rotate(float3{0, 1, 0}, 0.3f, Node == SCENE_NODE_CUBE7 ? PI_F : 0.0f));
+            Steps.push_back(Step::Translate(float3{1, 0, 0}));
+            Steps.push_back(Step::Rotate(float3{0, 1, 0}, 0.5f));
+            Steps.push_back(Step::Translate(float3{3, -3, 0}));
+            GetNodeAnimationSteps(SCENE_NODE_CUBE1, Steps);
+            break;
+
+        case SCENE_NODE_CUBE8:
+            Steps.push_back(Step::Translate(float3{0, 5, 0}));
+            Steps.push_back(Step::Rotate(float3{0, 1, 0}, -0.5f));
+            Steps.push_back(Step::Rotate(float3{1, 0, 0}, 0.0f, -PI_F * 0.1f));
+            break;
+
+        default:
+            // The grid does not move
+            break;
+    }
+}
+
+void Tutorial03_Texturing::Update(double CurrTime, double ElapsedTime)
+{
+    SampleBase::Update(CurrTime, ElapsedTime);
+    UpdateUI();
+
+    m_CurrTime = CurrTime;
+
+    // Pipelines that compile after startup are added to the cache as well
+    if (CurrTime - m_PipelineCacheSaveTime > PipelineCacheSavePeriod)
+    {
+        m_PipelineCache->Save();
+        m_PipelineCacheSaveTime = CurrTime;
+    }
+
+    // Objects of the nodes that did not move keep their transforms from the previous update
+    float4x4 NodeTransforms[SCENE_NODE_COUNT];
+    ComputeNodeTransforms(static_cast<float>(CurrTime), NodeTransforms);
+    bool NodeMoved[SCENE_NODE_COUNT] = {};
+    for (Uint32 Node = 0; Node < SCENE_NODE_COUNT; ++Node)
+    {
+        NodeMoved[Node]        = m_UpdateAllObjects || NodeTransforms[Node] != m_NodeTransforms[Node];
+        m_NodeTransforms[Node] = NodeTransforms[Node];
+    }
+
     // Camera is at (0, 0, -5) looking along the Z axis
     float4x4 View = float4x4::Translation(0.f, 1.0f, 30.0f);
 
@@ -394,21 +1653,81 @@ void Tutorial03_Texturing::Update(double CurrTime, double ElapsedTime)
     auto SrfPreTransform = GetSurfacePretransformMatrix(float3{0, 0, 1});
 
     // Get projection matrix adjusted to the current screen orientation
-    auto Proj = GetAdjustedProjectionMatrix(PI_F / 4.0f, 0.1f, 100.f);
-
-    // Compute world-view-projection matrix for all cubes
-    m_WorldViewProjMatrix1  = Cube1ModelTransform * View * SrfPreTransform * Proj;      // Cubo central
-    m_WorldViewProjMatrix2  = Cube2ModelTransform * View * SrfPreTransform * Proj;      // Cubo derecho
-    m_WorldViewProjMatrix3  = Cube3ModelTransform * View * SrfPreTransform * Proj;      // Cubo izquierdo
-    m_WorldViewProjMatrix4  = Cube4ModelTransform * View * SrfPreTransform * Proj;      // Cubo debajo del derecho
-    m_WorldViewProjMatrix5  = Cube5ModelTransform * View * SrfPreTransform * Proj;      // Cubo debajo del izquierdo
-    m_WorldViewProjMatrix6  = Cube6ModelTransform * View * SrfPreTransform * Proj;      // Cubo a la derecha del cubo 4 (órbita + rotación propia)
-    m_WorldViewProjMatrix7  = Cube7ModelTransform * View * SrfPreTransform * Proj;      // Cubo a la izquierda del cubo 4 (órbita + rotación propia)
-    m_WorldViewProjMatrix8  = Cube8ModelTransform * View * SrfPreTransform * Proj;      // Cubo arriba del cubo central
-    m_WorldViewProjMatrix9  = CubeLineModelTransform * View * SrfPreTransform * Proj;   // Cubo alargado (línea entre cubo central y cubo 8)
-    m_WorldViewProjMatrix10 = CubeLine23ModelTransform * View * SrfPreTransform * Proj; // Cubo alargado (línea entre cubo 2 y cubo 3)
-    m_WorldViewProjMatrix11 = CubeLine24ModelTransform * View * SrfPreTransform * Proj; // Cubo alargado (línea entre cubo 2 y cubo 4)
-    m_WorldViewProjMatrix12 = CubeLine35ModelTransform * View * SrfPreTransform * Proj; // Cubo alargado (línea entre cubo 3 y cubo 5)
+    auto Proj = GetAdjustedProjectionMatrix(PI_F / 4.0f, CameraNearPlane, CameraFarPlane);
+
+    m_ViewMatrix     = View;
+    m_ViewProjMatrix = View * SrfPreTransform * Proj;
+
+    // Baked objects are animated by the vertex shader of the CPU paths. With GPU animation,
+    // the GPU-driven path computes the transforms of all objects itself.
+    const bool GPUDriven      = m_GPUScene && m_RenderSettings.GPUDriven;
+    const bool BakedAnimation = m_AnimationTexture && m_RenderSettings.BakedAnimation && !GPUDriven;
+    const bool GPUAnimation   = GPUDriven && m_RenderSettings.GPUAnimation;
+
+    if (GPUDriven)
+    {
+        // The GPU-driven path only reads the model transforms, so only the objects of the nodes
+        // that moved are visited. Their records are updated in place and uploaded as patches.
+        if (!GPUAnimation)
+        {
+            for (Uint32 Node = 0; Node < SCENE_NODE_COUNT; ++Node)
+            {
+                if (!NodeMoved[Node])
+                    continue;
+
+                for (Uint32 ObjId : m_NodeObjects[Node])
+                {
+                    SceneObject& Obj   = m_Objects[ObjId];
+                    Obj.ModelTransform = Obj.LocalTransform * m_NodeTransforms[Node];
+                    if (!m_RebuildGPUSceneObjects)
+                    {
+                        m_GPUSceneObjects[ObjId].World = Obj.ModelTransform;
+                        m_DirtyGPUSceneObjects.push_back(ObjId);
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // Compute world-view-projection matrix and view-space depth for all cubes
+        for (SceneObject& Obj : m_Objects)
+        {
+            if (BakedAnimation && Obj.AnimationTrack != ~0u)
+                continue;
+
+            Obj.ModelTransform = Obj.LocalTransform * m_NodeTransforms[Obj.Node];
+
+            const float4x4 ModelView = Obj.ModelTransform * View;
+
+            Obj.WorldViewProj = ModelView * SrfPreTransform * Proj;
+            Obj.ViewDepth     = (float4{0, 0, 0, 1} * ModelView).z;
+        }
+    }
+
+    // Skipped objects have stale transforms, and records that are not maintained by the
+    // GPU-driven path must be rebuilt when it is enabled
+    m_UpdateAllObjects = GPUAnimation || BakedAnimation;
+    if (!GPUDriven || GPUAnimation)
+    {
+        m_DirtyGPUSceneObjects.clear();
+        m_RebuildGPUSceneObjects = true;
+    }
+
+    for (const SceneLine& Line : m_SceneLines)
+    {
+        const float4x4& NodeTransform = m_NodeTransforms[Line.Node];
+
+        const float4 Start = float4{Line.Start, 1} * NodeTransform;
+        const float4 End   = float4{Line.End, 1} * NodeTransform;
+        m_DebugDraw->Line(float3{Start.x, Start.y, Start.z}, float3{End.x, End.y, End.z}, float4{1, 1, 1, 1});
+    }
+
+    if (m_RenderSettings.ShowNodeAxes)
+    {
+        for (const float4x4& NodeTransform : m_NodeTransforms)
+            m_DebugDraw->Axes(NodeTransform, 1.5f);
+    }
 }
 
 } // namespace Diligent
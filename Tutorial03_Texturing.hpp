@@ -1,7 +1,28 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "SampleBase.hpp"
 #include "BasicMath.hpp"
+#include "SceneBatching.hpp"
+#include "CommandBundle.hpp"
+#include "DebugDraw.hpp"
+#include "GPUScene.hpp"
+#include "GPUAnimation.hpp"
+#include "FrustumCulling.hpp"
+#include "WorkerPool.hpp"
+#include "HiZPyramid.hpp"
+#include "SoftwareOcclusion.hpp"
+#include "OcclusionQueries.hpp"
+#include "MeshImport.hpp"
+#include "AnimationTexture.hpp"
+#include "MaterialSystem.hpp"
+#include "PipelineArchive.hpp"
+#include "PipelineCache.hpp"
+#include "ShaderFeatures.hpp"
+#include "ShaderOptimizer.hpp"
 
 namespace Diligent
 {
@@ -9,7 +30,11 @@ namespace Diligent
 class Tutorial03_Texturing final : public SampleBase
 {
 public:
-    virtual void Initialize(const SampleInitInfo& InitInfo) override final;
+    ~Tutorial03_Texturing() override;
+
+    virtual CommandLineStatus ProcessCommandLine(int argc, const char* const* argv) override final;
+    virtual void              ModifyEngineInitInfo(const ModifyEngineInitInfoAttribs& Attribs) override final;
+    virtual void              Initialize(const SampleInitInfo& InitInfo) override final;
 
     virtual void Render() override final;
     virtual void Update(double CurrTime, double ElapsedTime) override final;
@@ -17,33 +42,361 @@ public:
     virtual const Char* GetSampleName() const override final { return "Tutorial03: Texturing"; }
 
 private:
-    void CreatePipelineState();
-    void CreateVertexBuffer();
-    void CreateIndexBuffer();
+    // Binding indices of the resource signatures, grouped by how often the resources change
+    enum SIGNATURE_BINDING : Uint8
+    {
+        // Transform resources that change at most once per frame
+        SIGNATURE_BINDING_FRAME = 0,
+
+        // Texture of the material, shared by all color pipelines
+        SIGNATURE_BINDING_MATERIAL,
+
+        // Constant buffer that is rewritten before every draw
+        SIGNATURE_BINDING_DRAW
+    };
+
+    struct ScenePipelines
+    {
+        RefCntAutoPtr<IPipelineState> pColorPSO;
+        RefCntAutoPtr<IPipelineState> pDepthEqualPSO;
+        RefCntAutoPtr<IPipelineState> pDepthPrePassPSO;
+
+        // Transform resources of all three pipelines. The signature is bound at
+        // SIGNATURE_BINDING_DRAW for TRANSFORM_SOURCE_CONSTANTS and at
+        // SIGNATURE_BINDING_FRAME otherwise.
+        RefCntAutoPtr<IPipelineResourceSignature> pTransformSignature;
+        RefCntAutoPtr<IShaderResourceBinding>     pTransformSRB;
+
+        // Pipelines are compiled asynchronously when the device supports it.
+        // Returns true when all pipelines of the set can be used.
+        bool IsReady() const;
+        void WaitUntilReady() const;
+    };
+
+    // Where the vertex shader reads the transform of the current draw from
+    enum TRANSFORM_SOURCE
+    {
+        // World-view-projection matrix in a constant buffer updated before every draw
+        TRANSFORM_SOURCE_CONSTANTS = 0,
+
+        // Array of world-view-projection matrices indexed by the draw id attribute
+        TRANSFORM_SOURCE_DRAW_TRANSFORMS,
+
+        // GPU scene object records indexed by the draw id attribute
+        TRANSFORM_SOURCE_OBJECT_BUFFER,
+
+        // Transforms baked into the animation texture, with the draw id attribute as the track
+        TRANSFORM_SOURCE_ANIMATION_TEXTURE
+    };
+
+    void CreateMaterials();
+    void CreateTransformSignature(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines);
+    // With VertexPulling, vertices are read from the geometry pool by the vertex shader
+    // instead of the input assembler. Only valid with TRANSFORM_SOURCE_OBJECT_BUFFER.
+    void CreatePipelineState(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines);
+    // Material system variant of the color pipelines
+    static Uint32 GetPipelineVariant(TRANSFORM_SOURCE TransformSource, bool VertexPulling, bool DepthEqual)
+    {
+        return static_cast<Uint32>(TransformSource) | (VertexPulling ? 4u : 0u) | (DepthEqual ? 8u : 0u);
+    }
+    // Material system variant of the depth pre-pass pipelines
+    static Uint32 GetDepthPrePassVariant(TRANSFORM_SOURCE TransformSource, bool VertexPulling)
+    {
+        return GetPipelineVariant(TransformSource, VertexPulling, false) | 16u;
+    }
+    void CreateDepthPrePassPipelineState(TRANSFORM_SOURCE TransformSource, bool VertexPulling, ScenePipelines& Pipelines);
+    void CreateMeshes();
+    void CreateDrawIdBuffer();
     void LoadTexture();
+    void CreateScene();
+    void CreateBatches();
+    void GenerateObjects(Uint32 NumObjects);
+    // Must be called when objects are added or removed
+    void UpdateNodeObjects();
+    void CreateGPUScene(IShaderSourceInputStreamFactory* pShaderSourceFactory);
+    void CreateAnimationTexture();
+    void UpdateUI();
+
+    void CullObjects();
+    void CullOccludedObjects();
+    void CullObjectsWithQueries();
+    void PrepareDrawItems();
+    void SortDrawItems();
+    // With PositionsOnly, draws read the position streams for depth-only pipelines.
+    // Shader resources must be committed by the caller.
+    void DrawItems(bool PositionsOnly);
+    bool UpdateCommandBundles();
+    void RenderDrawItems(ITextureView* pRTV, ITextureView* pDSV);
+    void RenderGPUScene(ITextureView* pRTV, ITextureView* pDSV);
+    void RenderAnimatedObjects();
+    void UploadGPUAnimations();
+
+    // Animated transforms of the scene nodes at the given time
+    static void ComputeNodeTransforms(float Time, float4x4* pNodeTransforms);
+    // Appends the steps that the GPU animation pass uses to compute the same transform
+    static void GetNodeAnimationSteps(Uint32 Node, std::vector<GPUAnimation::Step>& Steps);
+
+    // Order in which opaque objects are submitted to the GPU
+    enum OPAQUE_ORDER : int
+    {
+        // Objects are drawn in the order they are declared in the scene
+        OPAQUE_ORDER_DECLARATION = 0,
+
+        // Objects are sorted front-to-back by their view-space depth every frame
+        OPAQUE_ORDER_FRONT_TO_BACK,
+    };
+
+    struct SceneRenderSettings
+    {
+        OPAQUE_ORDER OpaqueOrder = OPAQUE_ORDER_FRONT_TO_BACK;
+
+        // If true, depth is laid down by a position-only pass first, and the color
+        // pass then only shades pixels whose depth is EQUAL to the stored value.
+        bool DepthPrePass = false;
+
+        // If true, objects that never move relative to each other are merged into static
+        // batches at load time, and small moving objects are streamed into one dynamic batch.
+        bool Batching = true;
+
+        // If true, the draw list of the frame is built once and replayed on the CPU while it does
+        // not change. Only the transforms are uploaded each frame, but every command is still
+        // submitted, so this saves frame building rather than submission.
+        bool ReplayDrawList = true;
+
+        // If true, the draw arguments of all objects are generated by a compute pass
+        // and the scene is drawn with indirect draws. Batching and bundles are not used.
+        bool GPUDriven = false;
+
+        // If true, objects whose bounding spheres are outside of the view frustum are skipped.
+        // The GPU-driven path culls in its compute pass, other paths cull on the CPU.
+        bool FrustumCulling = true;
+
+        // If true, the GPU-driven path first draws the objects that were visible in the previous
+        // frame, builds a Hi-Z pyramid from their depth, and then only draws the remaining objects
+        // that are not hidden behind it.
+        bool OcclusionCulling = false;
+
+        // If true, the animation parameters of the objects are uploaded once, and the GPU-driven
+        // path computes their transforms in a compute pass from the time of the frame.
+        bool GPUAnimation = false;
+
+        // If true, the CPU paths rasterize the nearest visible objects into a small software
+        // depth buffer and skip the objects that are hidden behind them.
+        bool SoftwareOcclusionCulling = false;
+
+        // If true, the CPU paths draw the bounding box of every individually drawn object in
+        // an occlusion query after the scene, and skip the objects whose box was hidden the
+        // last time its query finished.
+        bool OcclusionQueries = false;
+
+        // If true, the CPU paths draw the objects of the animated scene nodes with transforms
+        // baked into a texture at startup. Their transforms are not computed on the CPU, and
+        // they are not culled.
+        bool BakedAnimation = false;
+
+        // Number of cubes added to the scene in a grid below it, to test how
+        // rendering scales with the number of objects
+        int NumGeneratedObjects = 0;
+
+        // Draws the axes of every scene node with the debug renderer
+        bool ShowNodeAxes = false;
+    };
+
+    // Maximum number of draws in a command bundle, limited by the size of the transforms buffer
+    static constexpr Uint32 MaxBundleDraws = 256;
+
+    static constexpr Uint32 MaxGPUSceneObjects = 1u << 17u;
+
+    // Scene nodes carry the animated transforms. Every object is attached to a node
+    // with a constant local transform.
+    enum SCENE_NODE : Uint32
+    {
+        SCENE_NODE_CUBE1 = 0,
+        SCENE_NODE_CUBE6,
+        SCENE_NODE_CUBE7,
+        SCENE_NODE_CUBE8,
+        SCENE_NODE_GRID,
+        SCENE_NODE_COUNT
+    };
+
+    struct SceneObject
+    {
+        Uint32   Node = SCENE_NODE_CUBE1;
+        float4x4 LocalTransform;
+
+        // Mesh 0 is the cube, the mesh given with --mesh is added after it.
+        // Only the logo material exists at the moment.
+        Uint32 Mesh     = 0;
+        Uint32 Material = 0;
+
+        // Objects that are not part of a static batch and are small enough
+        // are streamed into the dynamic batch every frame.
+        bool   Streamed = false;
+        bool   Batched  = false;
+        Uint32 BatchId  = 0;
+
+        // Track of the object in the animation texture, or ~0u if it is not animated
+        Uint32 AnimationTrack = ~0u;
+
+        float4x4 ModelTransform;
+        float4x4 WorldViewProj;
+        // View-space depth of the object's origin, used for sorting
+        float ViewDepth = 0;
+    };
+
+    // Line between two points in the space of a scene node, drawn as a debug overlay
+    struct SceneLine
+    {
+        Uint32 Node = SCENE_NODE_CUBE1;
+        float3 Start;
+        float3 End;
+    };
+
+    // Animated objects with the same mesh, drawn with one instanced draw. The instances
+    // are the consecutive animation tracks of the objects.
+    struct AnimatedGroup
+    {
+        Uint32 Mesh       = 0;
+        Uint32 FirstTrack = 0;
+        Uint32 NumTracks  = 0;
+    };
+
+    struct SceneBatch
+    {
+        Uint32                       Node = 0;
+        std::unique_ptr<StaticBatch> pBatch;
+    };
+
+    // Single draw call recorded for the current frame
+    struct DrawItem
+    {
+        IBuffer* pVertexBuffer      = nullptr;
+        // Positions of the same vertices, bound by depth-only passes
+        IBuffer* pPositionBuffer    = nullptr;
+        IBuffer* pIndexBuffer       = nullptr;
+        Uint32   NumIndices         = 0;
+        Uint32   FirstIndexLocation = 0;
+        Uint32   BaseVertex         = 0;
+        float4x4 WorldViewProj;
+        float    ViewDepth = 0;
+    };
+
+    BoundingSphere GetWorldBoundingSphere(const SceneObject& Obj) const;
+
+    ScenePipelines              m_Pipelines;
+    ScenePipelines              m_BundlePipelines;
+    ScenePipelines              m_GPUScenePipelines;
+    ScenePipelines              m_AnimatedPipelines;
+
+    std::unique_ptr<MaterialSystem> m_Materials;
+    MaterialSystem::MaterialId      m_DefaultMaterial = 0;
+
+    RefCntAutoPtr<IBuffer>      m_VSConstants;
+    RefCntAutoPtr<IBuffer>      m_DrawTransformsCB;
+    RefCntAutoPtr<IBuffer>      m_DrawIdBuffer;
+    RefCntAutoPtr<ITextureView> m_TextureSRV;
+
+    // All static geometry of the scene lives in the pool, so the pool buffers
+    // are bound once for everything except the dynamic batch.
+    std::unique_ptr<GeometryPool>         m_GeometryPool;
+    std::vector<GeometryPool::MeshHandle> m_Meshes;
+    std::vector<BoundingSphere>           m_MeshBounds;
+    // Optimized CPU-side geometry of the meshes, used for batching and to rasterize
+    // occluders. The views stay valid when m_MeshBuffers grows, since moving a
+    // vector keeps its data.
+    std::vector<MeshBuffers>              m_MeshBuffers;
+    std::vector<MeshData>                 m_MeshData;
+
+    // Indices of the objects of every scene node
+    std::vector<std::vector<Uint32>> m_NodeObjects;
+    // If true, transforms of all objects are recomputed in the next update, not only
+    // those of the nodes that moved
+    bool                             m_UpdateAllObjects = true;
+
+    SceneRenderSettings           m_RenderSettings;
+    std::vector<float4x4>         m_NodeTransforms;
+    std::vector<SceneObject>      m_Objects;
+    // Objects past this index were added by GenerateObjects()
+    size_t                        m_NumSceneObjects = 0;
+    std::vector<SceneLine>        m_SceneLines;
+    // Threads of the parallel CPU culling passes
+    std::unique_ptr<WorkerPool>   m_WorkerPool;
+    FrustumCuller                 m_FrustumCuller;
+    // Indices of the objects that passed CPU culling this frame
+    std::vector<Uint32>           m_VisibleObjects;
+    std::vector<SceneBatch>       m_StaticBatches;
+    std::unique_ptr<DynamicBatch> m_DynamicBatch;
+    std::vector<DrawItem>         m_DrawItems;
+    std::unique_ptr<DebugDraw>    m_DebugDraw;
+
+    // Null if the device does not support the GPU-driven path
+    std::unique_ptr<GPUScene>         m_GPUScene;
+    std::vector<GPUScene::ObjectData> m_GPUSceneObjects;
+    // Objects whose records were changed in m_GPUSceneObjects since the last upload
+    std::vector<Uint32>               m_DirtyGPUSceneObjects;
+    // Set when the records can not be patched and must be rebuilt from the objects
+    bool                              m_RebuildGPUSceneObjects = true;
+    std::unique_ptr<HiZPyramid>       m_HiZ;
+    std::unique_ptr<GPUAnimation>     m_GPUAnimation;
+    // Set when the objects change, so that their records and animations are uploaded again
+    bool                              m_GPUAnimationDirty = true;
+
+    std::unique_ptr<SoftwareOcclusionCuller> m_SoftwareOcclusion;
+    // Null if the device does not support occlusion queries
+    std::unique_ptr<OcclusionQueries> m_OcclusionQueries;
+
+    std::unique_ptr<AnimationTexture> m_AnimationTexture;
+    std::vector<AnimatedGroup>        m_AnimatedGroups;
+    double                            m_CurrTime = 0;
+
+    float4x4 m_ViewMatrix;
+    float4x4 m_ViewProjMatrix;
+
+    struct BundleDrawKey
+    {
+        IBuffer* pVertexBuffer;
+        IBuffer* pIndexBuffer;
+        Uint32   NumIndices;
+        Uint32   FirstIndexLocation;
+        Uint32   BaseVertex;
+
+        bool operator==(const BundleDrawKey& rhs) const
+        {
+            // clang-format off
+            return pVertexBuffer      == rhs.pVertexBuffer &&
+                   pIndexBuffer       == rhs.pIndexBuffer &&
+                   NumIndices         == rhs.NumIndices &&
+                   FirstIndexLocation == rhs.FirstIndexLocation &&
+                   BaseVertex         == rhs.BaseVertex;
+            // clang-format on
+        }
+    };
+
+    // If true, shaders and pipelines are compiled on the engine's thread pool
+    bool m_AsyncCompilation = false;
+
+    // If true, feature switches of the scene shaders are specialization constants
+    bool m_UseSpecializationConstants = false;
+
+    // Set by --bake_pipelines
+    bool                             m_BakePipelines = false;
+    std::unique_ptr<PipelineArchive> m_PipelineArchive;
+
+    // Wavefront OBJ file set by --mesh, and the index of its mesh if it was loaded
+    std::string m_ImportedMeshPath;
+    Uint32      m_ImportedMesh = ~0u;
+
+    // Only created when baking, and only if the shaders of the device are SPIR-V
+    std::unique_ptr<ShaderOptimizer> m_ShaderOptimizer;
 
-    RefCntAutoPtr<IPipelineState>         m_pPSO;
-    RefCntAutoPtr<IBuffer>                m_CubeVertexBuffer;
-    RefCntAutoPtr<IBuffer>                m_CubeIndexBuffer;
-    RefCntAutoPtr<IBuffer>                m_VSConstants;
-    RefCntAutoPtr<ITextureView>           m_TextureSRV;
-    RefCntAutoPtr<IShaderResourceBinding> m_SRB;
-    float4x4                              m_WorldViewProjMatrix;
-    float4x4                              m_WorldViewProjMatrix1;
-    float4x4                              m_WorldViewProjMatrix2;
-    float4x4                              m_WorldViewProjMatrix3;
-    float4x4                              m_WorldViewProjMatrix4;
-    float4x4                              m_WorldViewProjMatrix5;
-    float4x4                              m_WorldViewProjMatrix6;
-    float4x4                              m_WorldViewProjMatrix7;
-    float4x4                              m_WorldViewProjMatrix8;
-    float4x4                              m_WorldViewProjMatrix9;
-    float4x4                              m_WorldViewProjMatrix10;
-    float4x4                              m_WorldViewProjMatrix11;
-    float4x4                              m_WorldViewProjMatrix12;
-    float4x4                              m_WorldViewProjMatrix13;
-    float4x4                              m_WorldViewProjMatrix14;
+    std::unique_ptr<PersistentPipelineCache> m_PipelineCache;
+    double                                   m_PipelineCacheSaveTime = 0;
 
+    bool                       m_CommandBundlesSupported = false;
+    CommandBundle              m_DepthPrePassBundle;
+    CommandBundle              m_ColorBundle;
+    std::vector<BundleDrawKey> m_BundleSignature;
+    bool                       m_BundleDepthPrePass = false;
 };
 
 } // namespace Diligent
@@ -0,0 +1,88 @@
+#include "WorkerPool.hpp"
+
+namespace Diligent
+{
+
+WorkerPool::WorkerPool(Uint32 NumWorkers)
+{
+    m_Workers.reserve(NumWorkers);
+    for (Uint32 i = 0; i < NumWorkers; ++i)
+        m_Workers.emplace_back(&WorkerPool::WorkerThread, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock{m_Mtx};
+        m_Stop = true;
+    }
+    m_WakeCV.notify_all();
+    for (std::thread& Worker : m_Workers)
+        Worker.join();
+}
+
+Uint32 WorkerPool::RunTasks()
+{
+    Uint32 NumRun = 0;
+    for (Uint32 Task = m_NextTask.fetch_add(1); Task < m_NumTasks; Task = m_NextTask.fetch_add(1))
+    {
+        (*m_pTask)(Task);
+        ++NumRun;
+    }
+    return NumRun;
+}
+
+void WorkerPool::WorkerThread()
+{
+    Uint64 LastLoop = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> Lock{m_Mtx};
+            m_WakeCV.wait(Lock, [&]() { return m_Stop || m_Loop != LastLoop; });
+            if (m_Stop)
+                return;
+            LastLoop = m_Loop;
+            ++m_NumActive;
+        }
+
+        const Uint32 NumRun = RunTasks();
+
+        {
+            std::lock_guard<std::mutex> Lock{m_Mtx};
+            m_NumCompleted += NumRun;
+            --m_NumActive;
+        }
+        m_DoneCV.notify_all();
+    }
+}
+
+void WorkerPool::Run(Uint32 NumTasks, const std::function<void(Uint32)>& Task)
+{
+    if (NumTasks <= 1 || m_Workers.empty())
+    {
+        for (Uint32 i = 0; i < NumTasks; ++i)
+            Task(i);
+        return;
+    }
+
+    {
+        // Workers that woke up late for the previous loop may still be looking for its tasks
+        std::unique_lock<std::mutex> Lock{m_Mtx};
+        m_DoneCV.wait(Lock, [&]() { return m_NumActive == 0; });
+        m_pTask        = &Task;
+        m_NumTasks     = NumTasks;
+        m_NumCompleted = 0;
+        m_NextTask.store(0);
+        ++m_Loop;
+    }
+    m_WakeCV.notify_all();
+
+    const Uint32 NumRun = RunTasks();
+
+    std::unique_lock<std::mutex> Lock{m_Mtx};
+    m_NumCompleted += NumRun;
+    m_DoneCV.wait(Lock, [&]() { return m_NumCompleted == m_NumTasks; });
+}
+
+} // namespace Diligent
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BasicTypes.h"
+
+namespace Diligent
+{
+
+// Persistent worker threads for the parallel loops of the CPU culling passes.
+//
+// Threads are started once and sleep between loops, so a loop only costs a wake-up instead of
+// creating and joining threads. The calling thread takes part in every loop.
+class WorkerPool
+{
+public:
+    // NumWorkers threads are started in addition to the calling thread
+    explicit WorkerPool(Uint32 NumWorkers);
+    ~WorkerPool();
+
+    // clang-format off
+    WorkerPool           (const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    // clang-format on
+
+    // Number of threads that run the tasks of a loop, including the calling thread
+    Uint32 GetNumThreads() const { return static_cast<Uint32>(m_Workers.size()) + 1; }
+
+    // Runs Task(0) ... Task(NumTasks - 1) and returns when all of them have finished.
+    // Must not be called from a task.
+    void Run(Uint32 NumTasks, const std::function<void(Uint32)>& Task);
+
+private:
+    void WorkerThread();
+
+    // Runs tasks of the current loop until none are left, returns the number of tasks run
+    Uint32 RunTasks();
+
+    std::vector<std::thread> m_Workers;
+
+    std::mutex              m_Mtx;
+    std::condition_variable m_WakeCV;
+    std::condition_variable m_DoneCV;
+
+    // State of the current loop. Only changed while no worker is active.
+    const std::function<void(Uint32)>* m_pTask    = nullptr;
+    Uint32                             m_NumTasks = 0;
+    std::atomic<Uint32>                m_NextTask{0};
+
+    // Protected by m_Mtx
+    Uint64 m_Loop         = 0;
+    Uint32 m_NumCompleted = 0;
+    Uint32 m_NumActive    = 0;
+    bool   m_Stop         = false;
+};
+
+} // namespace Diligent